@@ -0,0 +1,61 @@
+/*
+ * Contention benchmark: events are passed to one machine from a growing
+ * number of threads, either to an atomic_state_machine or to a
+ * state_machine behind a mutex.
+ */
+#include "bench.hpp"
+#include "synthetic.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <pure/atomic.hpp>
+#include <pure/fsm.hpp>
+#include <thread>
+#include <vector>
+
+namespace {
+
+  using table = bench::dense_table<8, 4, pure::none>;
+
+  constexpr std::size_t events_per_thread = 1u << 20;
+
+  template <class Post>
+  double run_threads(std::size_t threads, Post post) {
+    return bench::ns_per_op(threads * events_per_thread, [&] {
+      std::vector<std::thread> workers;
+      for (std::size_t t = 0; t < threads; ++t)
+        workers.emplace_back([&, t] {
+          for (std::size_t i = 0; i < events_per_thread; ++i)
+            post((i + t) % table::event_collection::size());
+        });
+      for (auto& worker : workers) worker.join();
+    }, 3);
+  }
+
+} // namespace
+
+int main() {
+  const std::size_t cores =
+      std::max<std::size_t>(1, std::thread::hardware_concurrency());
+  char name[64];
+
+  for (std::size_t threads = 1;; threads = std::min(threads * 2, cores)) {
+    pure::atomic_state_machine<table> atomic;
+    double ns = run_threads(threads, [&](std::size_t id) {
+      atomic.dispatch(id);
+    });
+    std::snprintf(name, sizeof(name), "atomic/%zu threads", threads);
+    bench::report_rate(name, ns);
+
+    pure::state_machine<table> machine;
+    std::mutex mutex;
+    ns = run_threads(threads, [&](std::size_t id) {
+      std::lock_guard<std::mutex> lock(mutex);
+      machine.dispatch(id);
+    });
+    std::snprintf(name, sizeof(name), "mutex/%zu threads", threads);
+    bench::report_rate(name, ns);
+
+    if (threads == cores) break;
+  }
+}
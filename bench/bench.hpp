@@ -0,0 +1,73 @@
+/**
+ * @file bench.hpp
+ *
+ * Minimal benchmark harness, that has no dependencies and runs offline.
+ */
+#ifndef PUREFSM_BENCH_HPP
+#define PUREFSM_BENCH_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+
+namespace bench {
+
+  using clock = std::chrono::steady_clock;
+
+  /**
+   * @brief Prevents the compiler from optimizing away the value
+   */
+  template <typename T>
+  inline void keep(T const& value) noexcept {
+    asm volatile("" : : "r,m"(value) : "memory");
+  }
+
+  /**
+   * @brief Makes the object visible to the compiler as escaped, so its
+   * state can not be propagated across the measured loop
+   */
+  inline void escape(void* ptr) noexcept {
+    asm volatile("" : : "g"(ptr) : "memory");
+  }
+
+  /**
+   * @brief Forces the compiler to assume that all memory was changed
+   */
+  inline void clobber() noexcept { asm volatile("" : : : "memory"); }
+
+  /**
+   * @brief Returns the best time per operation in nanoseconds
+   *
+   * @param ops number of operations performed by one call of `body`
+   * @param body function to measure
+   *
+   * The body is called once to warm up and then measured `runs` times;
+   * the fastest run is taken, as it is the least disturbed by the system.
+   */
+  template <class F>
+  double ns_per_op(std::size_t ops, F&& body, int runs = 5) {
+    body();
+    double best = 0;
+    for (int run = 0; run < runs; ++run) {
+      auto start = clock::now();
+      body();
+      auto stop = clock::now();
+      double ns =
+          std::chrono::duration<double, std::nano>(stop - start).count();
+      best = run == 0 ? ns : std::min(best, ns);
+    }
+    return best / static_cast<double>(ops);
+  }
+
+  inline void report(const char* name, double ns) {
+    std::printf("%-48s %10.3f ns/op\n", name, ns);
+  }
+
+  inline void report_rate(const char* name, double ns) {
+    std::printf("%-48s %10.3f ns/op %12.1f Mop/s\n", name, ns, 1e3 / ns);
+  }
+
+} // namespace bench
+
+#endif
@@ -0,0 +1,86 @@
+/*
+ * Compile-time benchmark: for every synthetic table of 100, 500 and 2000
+ * transitions generates a translation unit, that instantiates a machine
+ * with the table, its `event` and its `dispatch`, compiles it and writes the
+ * compile time, the peak memory of the compiler and the object size as
+ * JSON. Nothing is linked or run.
+ *
+ * Usage: CompileBench [--max-transitions N] [--output FILE]
+ *
+ * The compiler is the one, that built the benchmark. POSIX only.
+ */
+#include "process.hpp"
+
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+
+  namespace fs = std::filesystem;
+
+  using bench::table_case;
+
+  // clang-format off
+  const table_case cases[] = {
+    {"dense/100", 100, "bench::dense_table<10, 10>"},
+    {"dense/100/guards", 100,
+     "bench::dense_table<10, 10, bench::counter, true>"},
+    {"sparse/100", 100, "bench::sparse_table<100, 10>"},
+    {"dense/500", 500, "bench::dense_table<25, 20>"},
+    {"dense/500/guards", 500,
+     "bench::dense_table<25, 20, bench::counter, true>"},
+    {"sparse/500", 500, "bench::sparse_table<500, 20>"},
+    {"dense/2000", 2000, "bench::dense_table<50, 40>"},
+    {"dense/2000/guards", 2000,
+     "bench::dense_table<50, 40, bench::counter, true>"},
+    {"sparse/2000", 2000, "bench::sparse_table<2000, 40>"},
+  };
+  // clang-format on
+
+  /*
+   * Compiles one case; returns its JSON object.
+   */
+  std::string compile_case(const table_case& c, const fs::path& dir) {
+    const std::string stem = bench::file_stem(c.name);
+    const fs::path source = dir / (stem + ".cpp");
+    const fs::path object = dir / (stem + ".o");
+
+    std::ofstream(source)
+        << "#include \"synthetic.hpp\"\n\n"
+        << "using table = " << c.type << ";\n"
+        << "using machine_t = pure::state_machine<table>;\n\n"
+        << "void event(machine_t& machine, std::size_t& count) {\n"
+        << "  machine.event<bench::event<0>>(count);\n"
+        << "}\n\n"
+        << "bool dispatch(machine_t& machine, std::size_t event,\n"
+        << "              std::size_t& count) {\n"
+        << "  return machine.dispatch(event, count);\n"
+        << "}\n";
+
+    std::ostringstream json;
+    json << "{\"name\": \"" << c.name << "\", \"transitions\": "
+         << c.transitions << ", \"table\": \"" << bench::json_escape(c.type)
+         << "\"";
+
+    std::fprintf(stderr, "%s: compiling\n", c.name);
+    const bench::process_result compiled =
+        bench::run(bench::compile_command(source, object));
+    if (!compiled.ok) {
+      json << ", \"error\": \"compilation failed\"}";
+      return json.str();
+    }
+    json << ", \"compile_seconds\": " << compiled.seconds
+         << ", \"compile_peak_kib\": " << compiled.peak_kib
+         << ", \"object_bytes\": " << fs::file_size(object) << "}";
+    return json.str();
+  }
+
+} // namespace
+
+int main(int argc, char** argv) {
+  return bench::run_cases(argc, argv, "compile", cases, compile_case);
+}
@@ -0,0 +1,109 @@
+/*
+ * Compares the table dispatch of state_machine::event with the recursive
+ * transition lookup, which was used before the dispatch table was introduced.
+ */
+#include "bench.hpp"
+#include "synthetic.hpp"
+
+#include <pure/fsm.hpp>
+#include <variant>
+
+namespace {
+
+  /*
+   * Reference implementation: nested std::visit over the state and the
+   * guard, followed by the recursive walk over the transition pack.
+   */
+  template <class Table>
+  class recursive_machine {
+  private:
+    using state_v = typename Table::state_v;
+    using guard_v = typename Table::guard_v;
+    using transition_pack = typename Table::transitions;
+
+    state_v m_state;
+    guard_v m_guard;
+
+    template <class State, class Event, class Guard, class Pack>
+    struct event_impl {
+      template <typename... Args>
+      inline void operator()(state_v&, Args&&...) noexcept {}
+    };
+
+    template <class State, class Event, class Guard, typename T,
+              typename... Ts>
+    struct event_impl<State, Event, Guard, tp::type_pack<T, Ts...>> {
+      template <typename... Args>
+      inline void operator()(state_v& state, Args&&... args) {
+        if constexpr (std::is_same_v<State, typename T::source_t> &&
+                      std::is_same_v<Event, typename T::event_t> &&
+                      pure::__details::match_v<Guard, typename T::guard_t>) {
+          state = typename T::target_t {};
+          typename T::action_t {}(std::forward<Args>(args)...);
+        } else
+          event_impl<State, Event, Guard, tp::type_pack<Ts...>> {}(
+              state, std::forward<Args>(args)...);
+      }
+    };
+
+  public:
+    recursive_machine()
+        : m_state(tp::at_t<0, typename Table::sources> {}),
+          m_guard(pure::none {}) {}
+
+    template <typename Event, typename... Args>
+    void event(Args&&... args) {
+      state_v& ref_state = m_state;
+      guard_v& ref_guard = m_guard;
+      auto l = [&](const auto& arg) {
+        auto gl = [&](const auto& arg2) {
+          using state_t = std::decay_t<decltype(arg)>;
+          using guard_t = std::decay_t<decltype(arg2)>;
+          event_impl<state_t, Event, guard_t, transition_pack> {}(
+              ref_state, std::forward<Args>(args)...);
+        };
+        std::visit(gl, ref_guard);
+      };
+      std::visit(l, m_state);
+    }
+  };
+
+  constexpr std::size_t rounds = 20000;
+
+  template <std::size_t States, std::size_t Events>
+  void run(const char* table_name) {
+    using table = bench::dense_table<States, Events>;
+    using events = std::make_index_sequence<Events>;
+    char name[64];
+
+    pure::state_machine<table> machine;
+    std::size_t count = 0;
+    bench::escape(&machine);
+    double ns = bench::ns_per_op(rounds * Events, [&] {
+      for (std::size_t i = 0; i < rounds; ++i) {
+        bench::send_all(machine, count, events {});
+      }
+    });
+    std::snprintf(name, sizeof(name), "table/%s", table_name);
+    bench::report(name, ns);
+
+    recursive_machine<table> reference;
+    bench::escape(&reference);
+    ns = bench::ns_per_op(rounds * Events, [&] {
+      for (std::size_t i = 0; i < rounds; ++i) {
+        bench::send_all(reference, count, events {});
+      }
+    });
+    std::snprintf(name, sizeof(name), "recursive/%s", table_name);
+    bench::report(name, ns);
+
+    bench::keep(count);
+  }
+
+} // namespace
+
+int main() {
+  run<10, 1>("10 transitions");
+  run<10, 10>("100 transitions");
+  run<16, 12>("192 transitions");
+}
@@ -0,0 +1,104 @@
+/*
+ * Throughput and latency of a machine fleet: events/s from 1 to all cores,
+ * and the 99th percentile of the time from posting an event to its
+ * transition.
+ */
+#include "bench.hpp"
+#include "synthetic.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <pure/fleet.hpp>
+#include <pure/fsm.hpp>
+#include <thread>
+#include <vector>
+
+namespace {
+
+  /*
+   * Fixed-size storage of latency samples, filled by the workers.
+   */
+  struct samples {
+    static constexpr std::size_t capacity = 1u << 16;
+
+    std::atomic<std::size_t> size {0};
+    std::vector<std::int64_t> values = std::vector<std::int64_t>(capacity);
+  };
+
+  inline std::int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               bench::clock::now().time_since_epoch())
+        .count();
+  }
+
+  /*
+   * Payload of an event: the time it was posted, if it is sampled.
+   */
+  struct probe {
+    std::int64_t posted;
+    samples* sink;
+  };
+
+  struct record_latency {
+    void operator()(probe& p) const {
+      if (!p.sink) return;
+      const std::size_t idx = p.sink->size.fetch_add(1);
+      if (idx < samples::capacity) p.sink->values[idx] = now_ns() - p.posted;
+    }
+  };
+
+  using table = bench::dense_table<8, 4, record_latency>;
+  using fleet_t = pure::machine_fleet<table, std::uint64_t, probe, 4096>;
+
+  constexpr std::size_t events_per_producer = 1u << 20;
+  constexpr std::size_t keys = 1u << 16;
+
+  void run(std::size_t workers) {
+    samples sink;
+    const auto start = bench::clock::now();
+    {
+      fleet_t fleet(workers, workers);
+      std::vector<std::thread> producers;
+      for (std::size_t p = 0; p < workers; ++p)
+        producers.emplace_back([&, p] {
+          std::uint64_t key = p;
+          for (std::size_t i = 0; i < events_per_producer; ++i) {
+            key = key * 6364136223846793005ull + 1442695040888963407ull;
+            probe pr {0, nullptr};
+            if (i % 64 == 0) pr = probe {now_ns(), &sink};
+            const std::size_t event = i % table::event_collection::size();
+            while (!fleet.post(p, key % keys, event, pr))
+              std::this_thread::yield();
+          }
+        });
+      for (auto& producer : producers) producer.join();
+      fleet.stop();
+    }
+    const double ns = std::chrono::duration<double, std::nano>(
+                          bench::clock::now() - start)
+                          .count() /
+                      static_cast<double>(workers * events_per_producer);
+
+    auto& values = sink.values;
+    values.resize(std::min(sink.size.load(), samples::capacity));
+    std::sort(values.begin(), values.end());
+    const auto p99 = values.empty() ? 0 : values[values.size() * 99 / 100];
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "fleet/%zu workers", workers);
+    bench::report_rate(name, ns);
+    std::printf("%-48s %10.3f us p99 post to transition\n", name,
+                static_cast<double>(p99) / 1e3);
+  }
+
+} // namespace
+
+int main() {
+  const std::size_t cores =
+      std::max<std::size_t>(1, std::thread::hardware_concurrency());
+  for (std::size_t workers = 1;; workers = std::min(workers * 2, cores)) {
+    run(workers);
+    if (workers == cores) break;
+  }
+}
@@ -0,0 +1,56 @@
+/*
+ * Journal benchmark: appending of events with group commit, and replay of
+ * the journal into an array of machines from 1 to all cores.
+ */
+#include "bench.hpp"
+#include "synthetic.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <pure/fsm.hpp>
+#include <pure/journal.hpp>
+#include <thread>
+#include <vector>
+
+namespace {
+
+  using table = bench::dense_table<8, 4, pure::none>;
+  using machine_t = pure::state_machine<table>;
+
+  constexpr std::size_t machines = 1u << 16;
+  constexpr std::size_t records = 1u << 22;
+  constexpr const char* path = "journal_bench.bin";
+
+  inline std::uint32_t machine_of(std::size_t idx) noexcept {
+    return static_cast<std::uint32_t>(idx * 2654435761u % machines);
+  }
+
+} // namespace
+
+int main() {
+  const std::size_t cores =
+      std::max<std::size_t>(1, std::thread::hardware_concurrency());
+  char name[64];
+
+  std::remove(path);
+  const double append_ns = bench::ns_per_op(records, [] {
+    std::remove(path);
+    pure::event_journal<table, pure::none, 1u << 14> journal(path);
+    for (std::size_t idx = 0; idx < records; ++idx)
+      journal.append(machine_of(idx), idx % table::event_collection::size());
+  }, 3);
+  bench::report_rate("append/group 16384", append_ns);
+
+  pure::journal_reader<table> reader(path);
+  for (std::size_t threads = 1;; threads = std::min(threads * 2, cores)) {
+    std::vector<machine_t> array(machines);
+    const double ns = bench::ns_per_op(records, [&] {
+      bench::keep(reader.replay(array.data(), array.size(), threads));
+    }, 3);
+    std::snprintf(name, sizeof(name), "replay/%zu threads", threads);
+    bench::report_rate(name, ns);
+    if (threads == cores) break;
+  }
+  std::remove(path);
+}
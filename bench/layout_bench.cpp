@@ -0,0 +1,81 @@
+/*
+ * Dispatch table layout benchmark: the same sparse table with the dense and
+ * the displaced dispatch table, by `event` and by a runtime `dispatch`.
+ */
+#include "bench.hpp"
+#include "synthetic.hpp"
+
+#include <cstddef>
+#include <cstdio>
+#include <pure/fsm.hpp>
+#include <random>
+#include <vector>
+
+namespace {
+
+  constexpr std::size_t transitions = 600;
+  constexpr std::size_t events = 12;
+
+  using sparse = bench::sparse_table<transitions, events>;
+
+  struct dense_sparse : sparse {};
+
+  struct displaced_sparse : sparse {};
+
+} // namespace
+
+template <>
+struct pure::table_layout<dense_sparse> {
+  static constexpr dispatch_layout value = dispatch_layout::dense;
+};
+
+template <>
+struct pure::table_layout<displaced_sparse> {
+  static constexpr dispatch_layout value = dispatch_layout::displaced;
+};
+
+namespace {
+
+  constexpr std::size_t rounds = 20000;
+
+  template <class Table>
+  void run(const char* table_name, const std::vector<std::size_t>& ids) {
+    using report = pure::dispatch_report<Table>;
+    char name[96];
+
+    pure::state_machine<Table> machine;
+    std::size_t count = 0;
+    bench::escape(&machine);
+    double ns = bench::ns_per_op(rounds * events, [&] {
+      for (std::size_t i = 0; i < rounds; ++i)
+        bench::send_all(machine, count,
+                        std::make_index_sequence<events> {});
+    });
+    std::snprintf(name, sizeof(name), "event/%s, %zu of %zu bytes",
+                  table_name, report::bytes, report::dense_bytes);
+    bench::report(name, ns);
+
+    ns = bench::ns_per_op(ids.size(), [&] {
+      for (std::size_t id : ids) {
+        machine.dispatch(id, count);
+        bench::clobber();
+      }
+    });
+    std::snprintf(name, sizeof(name), "dispatch/%s", table_name);
+    bench::report(name, ns);
+
+    bench::keep(count);
+  }
+
+} // namespace
+
+int main() {
+  std::mt19937 random(7);
+  std::vector<std::size_t> ids(1u << 20);
+  for (auto& id : ids) id = random() % events;
+
+  static_assert(pure::dispatch_report<sparse>::layout ==
+                pure::dispatch_layout::displaced);
+  run<dense_sparse>("dense", ids);
+  run<displaced_sparse>("displaced", ids);
+}
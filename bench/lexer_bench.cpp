@@ -0,0 +1,74 @@
+/*
+ * Lexer benchmark: feeding of buffers of words, where transitions are
+ * frequent, and of long strings, where most of the bytes are idle. An op is
+ * a byte, so Mop/s is MB/s.
+ */
+#include "bench.hpp"
+
+#include <cstddef>
+#include <pure/fsm.hpp>
+#include <pure/lexer.hpp>
+#include <random>
+#include <string>
+
+namespace {
+
+  struct Space {};
+
+  struct Word {};
+
+  struct String {};
+
+  struct Escape {};
+
+  struct Count {
+    void operator()(std::size_t& tokens) { ++tokens; }
+  };
+
+  using lower = pure::byte_range<'a', 'z'>;
+  using blank = pure::byte_set<' ', '\n'>;
+  using quote = pure::byte_set<'"'>;
+
+  using pure::none;
+  using pure::tr;
+
+  using table = pure::transition_table<
+      tr<Space, lower, Word, none, none>,
+      tr<Space, quote, String, none, none>,
+      tr<Word, lower, Word, none, none>,
+      tr<Word, blank, Space, Count, none>,
+      tr<String, pure::byte_set<'\\'>, Escape, none, none>,
+      tr<String, quote, Space, Count, none>,
+      tr<String, pure::any_byte, String, none, none>,
+      tr<Escape, pure::any_byte, String, none, none>>;
+
+  constexpr std::size_t size = 1u << 24;
+
+  std::string make_input(std::size_t min, std::size_t max, bool quoted) {
+    std::mt19937 random(5);
+    std::string input;
+    while (input.size() < size) {
+      const std::size_t length = min + random() % (max - min + 1);
+      if (quoted) input += '"';
+      for (std::size_t idx = 0; idx < length; ++idx)
+        input += static_cast<char>('a' + random() % 26);
+      input += quoted ? "\" " : " ";
+    }
+    return input;
+  }
+
+  void run(const char* name, const std::string& input) {
+    pure::byte_lexer<table> lexer;
+    std::size_t tokens = 0;
+    const double ns = bench::ns_per_op(input.size(), [&] {
+      bench::keep(lexer.feed(input, tokens));
+    });
+    bench::report_rate(name, ns);
+  }
+
+} // namespace
+
+int main() {
+  run("feed/words 1-12", make_input(1, 12, false));
+  run("feed/strings 100-300", make_input(100, 300, true));
+}
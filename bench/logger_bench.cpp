@@ -0,0 +1,70 @@
+/*
+ * Logging overhead benchmark: the same machine and events without a logger,
+ * with the asynchronous ring_logger and with the synchronous user_logger,
+ * that writes into a stream without a buffer.
+ */
+#include "bench.hpp"
+#include "synthetic.hpp"
+
+#include <cstdio>
+#include <ostream>
+#include <pure/fsm.hpp>
+#include <pure/logger.hpp>
+#include <pure/ring_logger.hpp>
+#include <thread>
+#include <utility>
+
+namespace {
+
+  using table = bench::dense_table<16, 8>;
+
+  constexpr std::size_t burst = 64;
+  constexpr std::size_t bursts = 2000;
+
+  /*
+   * Sends bursts of events, that fit into the ring of a ring_logger, and
+   * lets the background thread drain the ring between the bursts; only the
+   * bursts are measured.
+   */
+  template <class Machine, class Wait>
+  double measure(Machine& machine, Wait wait) {
+    std::size_t count = 0;
+    bench::escape(&machine);
+    double total = 0;
+    for (std::size_t b = 0; b < bursts; ++b) {
+      wait();
+      auto start = bench::clock::now();
+      for (std::size_t i = 0; i < burst / 8; ++i)
+        bench::send_all(machine, count, std::make_index_sequence<8> {});
+      auto stop = bench::clock::now();
+      total += std::chrono::duration<double, std::nano>(stop - start).count();
+    }
+    bench::keep(count);
+    return total / static_cast<double>(burst * bursts);
+  }
+
+  void no_wait() {}
+
+} // namespace
+
+int main() {
+  pure::state_machine<table> plain;
+  bench::report("empty_logger", measure(plain, no_wait));
+
+  std::ostream null_stream(nullptr);
+  {
+    pure::ring_log_sink sink(null_stream);
+    pure::state_machine<table, pure::ring_logger> machine(
+        pure::ring_logger(sink, 1));
+    const double ns = measure(machine, [&] {
+      while (sink.pending()) std::this_thread::yield();
+    });
+    bench::report("ring_logger", ns);
+    sink.stop();
+    std::printf("%-48s %10zu\n", "ring_logger dropped records", sink.dropped());
+  }
+
+  pure::state_machine<table, pure::user_logger> machine(
+      pure::user_logger {null_stream});
+  bench::report("user_logger", measure(machine, no_wait));
+}
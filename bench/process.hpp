@@ -0,0 +1,172 @@
+/**
+ * @file process.hpp
+ *
+ * Helpers of the benchmarks, that build and run generated programs: running
+ * a program without a shell, measuring its time and peak memory, writing
+ * JSON, and the command line and the output of a set of cases. POSIX only.
+ */
+#ifndef PUREFSM_BENCH_PROCESS_HPP
+#define PUREFSM_BENCH_PROCESS_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+extern char** environ;
+
+namespace bench {
+
+  namespace fs = std::filesystem;
+
+  /**
+   * @brief Outcome of a program run
+   */
+  struct process_result {
+    bool ok = false;
+    double seconds = 0;
+    long peak_kib = 0;
+  };
+
+  /**
+   * @brief Runs the program and waits for it; the peak memory is the
+   * largest resident set of the program and of its children
+   */
+  inline process_result run(const std::vector<std::string>& args) {
+    std::vector<char*> argv;
+    for (const auto& arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(nullptr);
+
+    process_result result;
+    const auto start = std::chrono::steady_clock::now();
+    pid_t pid;
+    if (posix_spawnp(&pid, argv[0], nullptr, nullptr, argv.data(), environ))
+      return result;
+    int status = 0;
+    struct rusage usage {};
+    if (wait4(pid, &status, 0, &usage) != pid) return result;
+    const auto stop = std::chrono::steady_clock::now();
+
+    result.ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    result.seconds = std::chrono::duration<double>(stop - start).count();
+    result.peak_kib = usage.ru_maxrss;
+    return result;
+  }
+
+  /**
+   * @brief Command, that compiles the source into the object file with the
+   * compiler and the flags of the benchmarks
+   */
+  inline std::vector<std::string> compile_command(const fs::path& source,
+                                                  const fs::path& object) {
+    std::vector<std::string> command = {PUREFSM_BENCH_CXX};
+    std::istringstream flags(PUREFSM_BENCH_FLAGS);
+    for (std::string flag; flags >> flag;) command.push_back(flag);
+    command.insert(command.end(),
+                   {"-I" PUREFSM_BENCH_INCLUDE_DIR, "-I" PUREFSM_BENCH_DIR,
+                    "-c", source.string(), "-o", object.string()});
+    return command;
+  }
+
+  /**
+   * @brief Name of a case as a file name
+   */
+  inline std::string file_stem(const char* name) {
+    std::string stem = name;
+    for (char& ch : stem)
+      if (ch == '/') ch = '_';
+    return stem;
+  }
+
+  /**
+   * @brief Escapes the string for a JSON string literal
+   */
+  inline std::string json_escape(const std::string& str) {
+    std::string result;
+    for (char c : str) {
+      if (c == '"' || c == '\\') result.push_back('\\');
+      result.push_back(c);
+    }
+    return result;
+  }
+
+  /**
+   * @brief Contents of the file without trailing whitespace
+   */
+  inline std::string read_file(const fs::path& path) {
+    std::ifstream in(path);
+    std::string text((std::istreambuf_iterator<char>(in)),
+                     std::istreambuf_iterator<char>());
+    while (!text.empty() && (text.back() == '\n' || text.back() == ' '))
+      text.pop_back();
+    return text;
+  }
+
+  /**
+   * @brief Synthetic table, that is compiled by a benchmark program
+   */
+  struct table_case {
+    const char* name;
+    std::size_t transitions;
+    const char* type;
+  };
+
+  /**
+   * @brief Runs the cases and writes their JSON objects, with the compiler
+   * and its flags, to the file of `--output` or to stdout
+   *
+   * @param argc, argv command line: `[--max-transitions N] [--output FILE]`
+   * @param dir_name directory in the current one for the generated files
+   * @param cases the cases; ones with more than `--max-transitions`
+   * transitions are skipped
+   * @param run_case function, that takes a case and the directory and
+   * returns the JSON object of the case
+   */
+  template <std::size_t N, class F>
+  int run_cases(int argc, char** argv, const char* dir_name,
+                const table_case (&cases)[N], F run_case) {
+    std::size_t max_transitions = static_cast<std::size_t>(-1);
+    const char* output = nullptr;
+    for (int idx = 1; idx + 1 < argc; idx += 2) {
+      if (!std::strcmp(argv[idx], "--max-transitions"))
+        max_transitions = std::strtoul(argv[idx + 1], nullptr, 10);
+      else if (!std::strcmp(argv[idx], "--output"))
+        output = argv[idx + 1];
+    }
+
+    const fs::path dir = fs::current_path() / dir_name;
+    fs::create_directories(dir);
+
+    std::ostringstream json;
+    json << "{\n  \"compiler\": \"" << json_escape(PUREFSM_BENCH_CXX)
+         << "\",\n  \"flags\": \"" << json_escape(PUREFSM_BENCH_FLAGS)
+         << "\",\n  \"cases\": [";
+    bool first = true;
+    for (const auto& c : cases) {
+      if (c.transitions > max_transitions) continue;
+      json << (first ? "\n    " : ",\n    ") << run_case(c, dir);
+      first = false;
+    }
+    json << "\n  ]\n}\n";
+
+    if (output)
+      std::ofstream(output) << json.str();
+    else
+      std::fputs(json.str().c_str(), stdout);
+    return 0;
+  }
+
+} // namespace bench
+
+#endif
@@ -0,0 +1,55 @@
+/*
+ * Throughput of batch processing of runtime events, compared with the
+ * dispatch of the same events one by one.
+ */
+#include "bench.hpp"
+#include "synthetic.hpp"
+
+#include <cstdint>
+#include <pure/fsm.hpp>
+#include <random>
+#include <vector>
+
+namespace {
+
+  using table = bench::dense_table<16, 8, pure::none>;
+  using machine_t = pure::state_machine<table>;
+
+  void run(std::size_t batch, const char* batch_name) {
+    std::vector<std::uint8_t> events(batch);
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<unsigned> dist(
+        0, table::event_collection::size() - 1);
+    for (auto& event : events) event = static_cast<std::uint8_t>(dist(gen));
+
+    // Small batches are repeated, so every measurement covers ~16M events
+    const std::size_t repeat = std::max<std::size_t>(1, (1u << 24) / batch);
+    char name[64];
+
+    machine_t machine;
+    bench::escape(&machine);
+    std::size_t count = 0;
+    double ns = bench::ns_per_op(batch * repeat, [&] {
+      for (std::size_t i = 0; i < repeat; ++i)
+        machine.process(events, count);
+    }, 3);
+    std::snprintf(name, sizeof(name), "process/%s", batch_name);
+    bench::report_rate(name, ns);
+
+    ns = bench::ns_per_op(batch * repeat, [&] {
+      for (std::size_t i = 0; i < repeat; ++i)
+        for (auto event : events) machine.dispatch(event, count);
+    }, 3);
+    std::snprintf(name, sizeof(name), "dispatch/%s", batch_name);
+    bench::report_rate(name, ns);
+
+    bench::keep(count);
+  }
+
+} // namespace
+
+int main() {
+  run(1u << 10, "1k events");
+  run(1u << 16, "64k events");
+  run(1u << 24, "16M events");
+}
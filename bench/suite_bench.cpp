@@ -0,0 +1,98 @@
+/*
+ * Benchmark suite: for every synthetic table (10, 100 and 1000 transitions,
+ * dense and sparse, with and without guards) generates a program, measures
+ * the time and the peak memory of its compilation and the size of its
+ * object file, runs it to measure the cost of event(), action() and
+ * guard(), and writes all results as JSON.
+ *
+ * Usage: SuiteBench [--max-transitions N] [--output FILE]
+ *
+ * The compiler is the one, that built the suite; it runs without a shell
+ * and without network access. POSIX only.
+ */
+#include "process.hpp"
+
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+
+  namespace fs = std::filesystem;
+
+  using bench::table_case;
+
+  // clang-format off
+  const table_case cases[] = {
+    {"dense/10", 10, "bench::dense_table<5, 2>"},
+    {"dense/10/guards", 10, "bench::dense_table<5, 2, bench::counter, true>"},
+    {"sparse/10", 10, "bench::sparse_table<10, 5>"},
+    {"sparse/10/guards", 10,
+     "bench::sparse_table<10, 5, bench::counter, true>"},
+    {"dense/100", 100, "bench::dense_table<10, 10>"},
+    {"dense/100/guards", 100,
+     "bench::dense_table<10, 10, bench::counter, true>"},
+    {"sparse/100", 100, "bench::sparse_table<100, 10>"},
+    {"sparse/100/guards", 100,
+     "bench::sparse_table<100, 10, bench::counter, true>"},
+    {"dense/1000", 1000, "bench::dense_table<40, 25>"},
+    {"dense/1000/guards", 1000,
+     "bench::dense_table<40, 25, bench::counter, true>"},
+    {"sparse/1000", 1000, "bench::sparse_table<1000, 25>"},
+    {"sparse/1000/guards", 1000,
+     "bench::sparse_table<1000, 25, bench::counter, true>"},
+  };
+  // clang-format on
+
+  /*
+   * Builds and runs one case; returns its JSON object.
+   */
+  std::string run_case(const table_case& c, const fs::path& dir) {
+    const std::string stem = bench::file_stem(c.name);
+    const fs::path source = dir / (stem + ".cpp");
+    const fs::path object = dir / (stem + ".o");
+    const fs::path program = dir / stem;
+    const fs::path output = dir / (stem + ".json");
+
+    std::ofstream(source) << "#include \"suite_case.hpp\"\n\n"
+                          << "int main(int argc, char** argv) {\n"
+                          << "  return bench::run_case<" << c.type
+                          << ">(argc > 1 ? argv[1] : nullptr);\n"
+                          << "}\n";
+
+    std::ostringstream json;
+    json << "{\"name\": \"" << c.name << "\", \"transitions\": "
+         << c.transitions << ", \"table\": \"" << bench::json_escape(c.type)
+         << "\"";
+
+    std::fprintf(stderr, "%s: compiling\n", c.name);
+    const bench::process_result compiled =
+        bench::run(bench::compile_command(source, object));
+    if (!compiled.ok) {
+      json << ", \"error\": \"compilation failed\"}";
+      return json.str();
+    }
+    json << ", \"compile_seconds\": " << compiled.seconds
+         << ", \"compile_peak_kib\": " << compiled.peak_kib
+         << ", \"object_bytes\": " << fs::file_size(object);
+
+    std::fprintf(stderr, "%s: running\n", c.name);
+    if (!bench::run({PUREFSM_BENCH_CXX, object.string(), "-o",
+                     program.string()})
+             .ok ||
+        !bench::run({program.string(), output.string()}).ok) {
+      json << ", \"error\": \"run failed\"}";
+      return json.str();
+    }
+    json << ", \"runtime\": " << bench::read_file(output) << "}";
+    return json.str();
+  }
+
+} // namespace
+
+int main(int argc, char** argv) {
+  return bench::run_cases(argc, argv, "suite", cases, run_case);
+}
@@ -0,0 +1,79 @@
+/**
+ * @file suite_case.hpp
+ *
+ * Runtime part of one case of the benchmark suite: the suite generates a
+ * program per table, that calls `run_case`.
+ */
+#ifndef PUREFSM_BENCH_SUITE_CASE_HPP
+#define PUREFSM_BENCH_SUITE_CASE_HPP
+
+#include "bench.hpp"
+#include "synthetic.hpp"
+
+#include <cstddef>
+#include <cstdio>
+#include <pure/fsm.hpp>
+#include <utility>
+
+namespace bench {
+
+  /**
+   * @brief Measures the costs of `event`, `action` and `guard` of a machine
+   * with the table and writes them, with the layout and the size of its
+   * dispatch table, as a JSON object to the file `path`, or to stdout, if it
+   * is null
+   */
+  template <class Table>
+  int run_case(const char* path) {
+    using machine_t = pure::state_machine<Table>;
+    using guard_t = tp::at_t<0, typename Table::guard_collection>;
+
+    constexpr std::size_t events = Table::event_collection::size();
+    constexpr std::size_t ops = 1u << 20;
+    constexpr std::size_t rounds = ops / events + 1;
+
+    machine_t machine;
+    std::size_t count = 0;
+    escape(&machine);
+
+    const double event_ns = ns_per_op(rounds * events, [&] {
+      for (std::size_t r = 0; r < rounds; ++r)
+        send_all(machine, count, std::make_index_sequence<events> {});
+    });
+
+    const double action_ns = ns_per_op(ops, [&] {
+      for (std::size_t i = 0; i < ops; ++i) {
+        machine.action(count);
+        clobber();
+      }
+    });
+
+    const double guard_ns = ns_per_op(ops, [&] {
+      for (std::size_t i = 0; i < ops / 2; ++i) {
+        machine.template guard<guard_t>();
+        clobber();
+        machine.template guard<pure::none>();
+        clobber();
+      }
+    });
+    keep(count);
+
+    using report = pure::dispatch_report<Table>;
+    const bool displaced = report::layout == pure::dispatch_layout::displaced;
+
+    std::FILE* out = path ? std::fopen(path, "w") : stdout;
+    if (!out) return 1;
+    std::fprintf(out,
+                 "{\"event_ns\": %.3f, \"action_ns\": %.3f, "
+                 "\"guard_ns\": %.3f, \"layout\": \"%s\", "
+                 "\"dispatch_bytes\": %zu, \"dense_bytes\": %zu}\n",
+                 event_ns, action_ns, guard_ns,
+                 displaced ? "displaced" : "dense", report::bytes,
+                 report::dense_bytes);
+    if (path) std::fclose(out);
+    return 0;
+  }
+
+} // namespace bench
+
+#endif
@@ -0,0 +1,127 @@
+/**
+ * @file synthetic.hpp
+ *
+ * Generators of synthetic transition tables for the benchmarks.
+ */
+#ifndef PUREFSM_BENCH_SYNTHETIC_HPP
+#define PUREFSM_BENCH_SYNTHETIC_HPP
+
+#include "bench.hpp"
+
+#include <cstddef>
+#include <pure/fsm.hpp>
+#include <type_traits>
+#include <utility>
+
+namespace bench {
+
+  template <std::size_t I>
+  struct state {};
+
+  template <std::size_t I>
+  struct event {};
+
+  template <std::size_t I>
+  struct guard {};
+
+  /**
+   * @brief Action that counts its calls
+   */
+  struct counter {
+    void operator()(std::size_t& count) const noexcept { ++count; }
+  };
+
+  namespace __details {
+
+    /*
+     * Guard of the transition I of a guarded table: every fourth transition
+     * has no guard, the others have a plain guard, an any_of and a none_of
+     * guard in turn.
+     */
+    template <std::size_t I, bool Guarded>
+    struct guard_of {
+      using type = pure::none;
+    };
+
+    template <std::size_t I>
+    struct guard_of<I, true> {
+      using type = std::conditional_t<
+          I % 4 == 0, pure::none,
+          std::conditional_t<
+              I % 4 == 1, guard<0>,
+              std::conditional_t<I % 4 == 2, pure::any_of<guard<1>, guard<2>>,
+                                 pure::none_of<guard<3>>>>>;
+    };
+
+    template <std::size_t I, bool Guarded>
+    using guard_of_t = typename guard_of<I, Guarded>::type;
+
+    template <std::size_t States, std::size_t Events, class Action,
+              bool Guarded, class Seq>
+    struct dense_table;
+
+    template <std::size_t States, std::size_t Events, class Action,
+              bool Guarded, std::size_t... Is>
+    struct dense_table<States, Events, Action, Guarded,
+                       std::index_sequence<Is...>> {
+      using type = pure::transition_table<
+          pure::tr<state<Is % States>, event<Is / States>,
+                   state<(Is % States + Is / States + 1) % States>, Action,
+                   guard_of_t<Is, Guarded>>...>;
+    };
+
+    template <std::size_t Events, class Action, bool Guarded, class Seq>
+    struct sparse_table;
+
+    template <std::size_t Events, class Action, bool Guarded,
+              std::size_t... Is>
+    struct sparse_table<Events, Action, Guarded, std::index_sequence<Is...>> {
+      using type = pure::transition_table<
+          pure::tr<state<Is>, event<Is % Events>,
+                   state<(Is + 1) % sizeof...(Is)>, Action,
+                   guard_of_t<Is, Guarded>>...>;
+    };
+
+  } // namespace __details
+
+  /**
+   * @brief Table, where every state has a transition by every event
+   *
+   * The table has `States * Events` transitions; transition by event `e`
+   * moves from state `s` to state `(s + e + 1) % States` and calls Action.
+   * If Guarded, three of every four transitions have a plain guard, an
+   * `any_of` or a `none_of` guard.
+   */
+  template <std::size_t States, std::size_t Events, class Action = counter,
+            bool Guarded = false>
+  using dense_table = typename __details::dense_table<
+      States, Events, Action, Guarded,
+      std::make_index_sequence<States * Events>>::type;
+
+  /**
+   * @brief Table, where every state has a transition by one event only
+   *
+   * The table has `Transitions` states and transitions; state `s` moves to
+   * state `s + 1` by event `s % Events`, so only one of `Events` cells of the
+   * dispatch table is filled. Guards are the same as in dense_table.
+   */
+  template <std::size_t Transitions, std::size_t Events,
+            class Action = counter, bool Guarded = false>
+  using sparse_table = typename __details::sparse_table<
+      Events, Action, Guarded, std::make_index_sequence<Transitions>>::type;
+
+  /**
+   * @brief Sends every event of the sequence to the machine once
+   *
+   * Memory is clobbered after each event, so the compiler can not carry the
+   * known state of the machine from one event to the next one.
+   */
+  template <class Machine, std::size_t... Is>
+  inline void send_all(Machine& machine, std::size_t& count,
+                       std::index_sequence<Is...>) {
+    ((machine.template event<event<Is>>(count), clobber()), ...);
+  }
+
+} // namespace bench
+
+#endif
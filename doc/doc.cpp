@@ -38,12 +38,42 @@ namespace pure {
    * See @ref fsm_logger
    */
 
+  /**
+   * @struct empty_metrics
+   * @brief Empty metrics policy
+   *
+   * Metrics policy, that is specified as a State Machine metrics policy by
+   * default. It takes no space and the machine makes no calls to it.
+   *
+   * A metrics policy is required to define two methods:
+   *
+   * ```cpp
+   * template <class F>
+   * void transition(std::size_t transition_index, F&& perform);
+   * void unhandled(std::size_t state_index, std::size_t event_index);
+   * ```
+   *
+   * `transition` is called for every performed transition and must call
+   * `perform()`, which changes the state and calls the action. `unhandled`
+   * is called for every event, that caused no transition.
+   *
+   * See transition_metrics
+   */
+
   /**
    * @struct state_machine
    * @brief State Machine
    *
    * @tparam Table transition_table
    * @tparam Logger type that provides a logger interface
+   * @tparam Metrics metrics policy, see empty_metrics
+   *
+   * If all states and guards of the table are empty types, the machine keeps
+   * only the indices of the current state and guard, each in the smallest
+   * unsigned integer type that fits (usually `std::uint8_t`). An empty
+   * logger does not take any space, so such a machine with `empty_logger`
+   * is two bytes in size. Otherwise the state and the guard are kept in the
+   * variants `Table::state_v` and `Table::guard_v`.
    */
 
   /**
@@ -92,6 +122,23 @@ namespace pure {
    * D\f$, then it is matched to both transitions.
    */
 
+  /**
+   * @struct guard_predicate
+   * @brief Guard, that is checked by a predicate at the time of an event
+   *
+   * @tparam Predicate default constructible type with
+   * `bool operator()(Args&...) const`
+   *
+   * A transition with a predicate guard matches any current guard, if the
+   * predicate, called with the arguments of the event, returns true. The
+   * predicate is called only for the transitions, whose source state and
+   * event already matched, in the order of the table, until one of them is
+   * performed. A predicate, that can not be called with the arguments of the
+   * event, does not hold.
+   *
+   * Predicates are supported by `state_machine` and `multi_guard_machine`.
+   */
+
   /**
    * @struct stdout_logger
    * @brief State machine stdout logger
@@ -129,6 +176,12 @@ namespace pure {
    * reflection is a compiler-dependent feature. It should work with GNU GCC,
    * Clang, MSVC, Intel C++ Compiler and DMC.
    *
+   * `pure::logger::type_name` returns a `std::string_view`, that is computed
+   * at compile time, so it neither allocates nor scans the signature at run
+   * time. `pure::logger::type_ids<Table>` numbers the states, events and
+   * guards of a table densely, so a logger may record integers and resolve
+   * their names later with `type_ids<Table>::name`.
+   *
    * And non-template method `write`, that allows to just send log messages
    * ```cpp
    * void write(const char*);
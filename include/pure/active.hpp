@@ -0,0 +1,259 @@
+/**
+ * @file active.hpp
+ *
+ * File that contains an active object: a State Machine, which runs on its
+ * own thread and receives events through a bounded lock-free queue.
+ */
+#ifndef PUREFSM_ACTIVE_HPP
+#define PUREFSM_ACTIVE_HPP
+
+#include "fsm.hpp"
+#include "queue.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <thread>
+#include <type_traits>
+
+#if defined(__linux__)
+  #include <linux/futex.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+#endif
+
+namespace pure {
+
+  /**
+   * @brief Wait policy of an active_machine: the consumer thread spins,
+   * while the queue is empty
+   *
+   * Gives the lowest latency at the cost of one busy core.
+   */
+  struct spin_wait {
+    /** @cond undocumented */
+    static constexpr bool sleeps = false;
+
+    static inline void pause() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+      __builtin_ia32_pause();
+#endif
+    }
+    /** @endcond */
+  };
+
+  /**
+   * @brief Wait policy of an active_machine: the consumer thread sleeps on
+   * a futex, while the queue is empty
+   *
+   * Producers wake the consumer only if it sleeps. On systems without
+   * futexes the consumer yields instead of sleeping.
+   */
+  struct futex_wait {
+    /** @cond undocumented */
+    static constexpr bool sleeps = true;
+
+    static inline void wait(std::atomic<std::uint32_t>& word,
+                            std::uint32_t expected) noexcept {
+#if defined(__linux__)
+      syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word),
+              FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+      if (word.load(std::memory_order_relaxed) == expected)
+        std::this_thread::yield();
+#endif
+    }
+
+    static inline void wake(std::atomic<std::uint32_t>& word) noexcept {
+#if defined(__linux__)
+      syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word),
+              FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#else
+      (void) word;
+#endif
+    }
+    /** @endcond */
+  };
+
+  /**
+   * @brief State Machine, that runs on its own thread
+   *
+   * @tparam Table transition_table
+   * @tparam QueueCapacity capacity of the event queue, a power of two
+   * @tparam Payload type of a value, that is posted with an event and is
+   * passed to the transition action; `none` if events carry no value
+   * @tparam WaitPolicy `spin_wait` or `futex_wait`
+   *
+   * Any number of threads post events to the machine. An event is posted as
+   * its runtime index (see `state_machine::event_id`) together with a
+   * payload into a fixed-capacity lock-free queue, so posting neither
+   * allocates nor erases types. The machine thread takes events from the
+   * queue in batches of up to `batch_size` and runs every event to
+   * completion, i.e. performs the transition and its action, before taking
+   * the next one.
+   *
+   * The thread is started by the constructor. `stop` (and the destructor)
+   * processes the events, that are already in the queue, and joins the
+   * thread.
+   */
+  template <class Table, std::size_t QueueCapacity, class Payload = none,
+            class WaitPolicy = spin_wait>
+  class active_machine {
+  public:
+    using machine_t = state_machine<Table>;
+
+    /** @brief Number of events, taken from the queue between the waits */
+    static constexpr std::size_t batch_size =
+        QueueCapacity < 64 ? QueueCapacity : 64;
+
+    /**
+     * @brief Runtime index of the event Event
+     */
+    template <class Event>
+    static constexpr std::size_t event_id = machine_t::template event_id<Event>;
+
+  private:
+    using table = __details::compiled_table<Table>;
+
+    static_assert(std::is_nothrow_copy_assignable_v<Payload> &&
+                      std::is_nothrow_default_constructible_v<Payload>,
+                  "Payload must be nothrow copyable and constructible");
+
+    struct record {
+      std::uint32_t event;
+      Payload payload;
+    };
+
+    machine_t m_machine;
+    __details::mpsc_queue<record, QueueCapacity> m_queue;
+    alignas(64) std::atomic<std::uint32_t> m_sleeping {0};
+    std::atomic<bool> m_stop {false};
+    std::thread m_thread;
+
+    inline void run_one(record& rec) {
+      if constexpr (std::is_same_v<Payload, none>)
+        m_machine.dispatch(rec.event);
+      else
+        m_machine.dispatch(rec.event, rec.payload);
+    }
+
+    /*
+     * Takes up to batch_size events from the queue; returns their number.
+     */
+    inline std::size_t drain() {
+      record rec;
+      std::size_t count = 0;
+      while (count < batch_size && m_queue.pop(rec)) {
+        run_one(rec);
+        ++count;
+      }
+      return count;
+    }
+
+    void run() {
+      for (;;) {
+        if (drain()) continue;
+        if (m_stop.load(std::memory_order_acquire)) {
+          while (drain()) {}
+          return;
+        }
+        if constexpr (WaitPolicy::sleeps) {
+          m_sleeping.store(1, std::memory_order_seq_cst);
+          std::atomic_thread_fence(std::memory_order_seq_cst);
+          if (m_queue.empty() && !m_stop.load(std::memory_order_seq_cst))
+            WaitPolicy::wait(m_sleeping, 1);
+          m_sleeping.store(0, std::memory_order_relaxed);
+        } else
+          WaitPolicy::pause();
+      }
+    }
+
+    inline void notify() noexcept {
+      if constexpr (WaitPolicy::sleeps) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_sleeping.load(std::memory_order_relaxed) &&
+            m_sleeping.exchange(0, std::memory_order_relaxed))
+          WaitPolicy::wake(m_sleeping);
+      }
+    }
+
+  public:
+    inline active_machine() : m_thread([this] { run(); }) {}
+
+    active_machine(const active_machine&) = delete;
+    active_machine& operator=(const active_machine&) = delete;
+
+    inline ~active_machine() { stop(); }
+
+    /**
+     * @brief Post an event by its runtime index
+     *
+     * @return false, if the queue is full or the event is out of range; the
+     * event is not posted then
+     */
+    inline bool post(std::size_t event, const Payload& payload = {}) noexcept {
+      if (event >= table::event_count) return false;
+      const bool posted =
+          m_queue.push(record {static_cast<std::uint32_t>(event), payload});
+      notify();
+      return posted;
+    }
+
+    /**
+     * @brief Post an event
+     *
+     * @return false, if the queue is full; the event is not posted then
+     */
+    template <class Event>
+    inline bool post(const Payload& payload = {}) noexcept {
+      static_assert(table::template has_event<Event>,
+                    "Event is not in the table");
+      return post(event_id<Event>, payload);
+    }
+
+    /**
+     * @brief Post a batch of events by their runtime indices
+     *
+     * @return the number of posted events; posting stops at the first event,
+     * that is out of range or does not fit into the queue
+     *
+     * The machine thread is woken at most once per batch.
+     */
+    template <class It,
+              typename = typename std::iterator_traits<It>::iterator_category>
+    std::size_t post(It first, It last) noexcept {
+      std::size_t count = 0;
+      for (; first != last; ++first, ++count)
+        if (static_cast<std::size_t>(*first) >= table::event_count ||
+            !m_queue.push(
+                record {static_cast<std::uint32_t>(*first), Payload {}}))
+          break;
+      notify();
+      return count;
+    }
+
+    /**
+     * @brief Processes the posted events and stops the machine thread
+     */
+    void stop() {
+      if (!m_thread.joinable()) return;
+      m_stop.store(true, std::memory_order_seq_cst);
+      if constexpr (WaitPolicy::sleeps) {
+        m_sleeping.store(0, std::memory_order_relaxed);
+        WaitPolicy::wake(m_sleeping);
+      }
+      m_thread.join();
+    }
+
+    /**
+     * @brief The machine; may be inspected only after `stop` or from the
+     * transition actions
+     */
+    inline const machine_t& machine() const noexcept { return m_machine; }
+  };
+
+} // namespace pure
+
+#endif
@@ -0,0 +1,152 @@
+/**
+ * @file atomic.hpp
+ *
+ * File that contains a lock-free State Machine, which accepts events from
+ * several threads.
+ */
+#ifndef PUREFSM_ATOMIC_HPP
+#define PUREFSM_ATOMIC_HPP
+
+#include "fsm.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace pure {
+
+  /**
+   * @brief Lock-free State Machine
+   *
+   * @tparam Table transition_table
+   *
+   * The machine keeps its state and guard as one integer, the cell
+   * `state * G + guard`, where G is the number of guards, in a `std::atomic`.
+   * A transition is a compare-and-swap of the cell, found in the dispatch
+   * table, so events and guards may be passed from any number of threads
+   * without a lock.
+   *
+   * Actions rule: the action of a transition is called only by the thread,
+   * whose compare-and-swap performed the transition, and only after the new
+   * state was published. So every performed transition calls its action
+   * exactly once, but actions of consecutive transitions may run
+   * concurrently, and may observe a state, that is already changed by
+   * another thread. Actions must be thread-safe.
+   *
+   * The machine does not log: loggers are not thread-safe.
+   */
+  template <class Table>
+  class atomic_state_machine {
+  private:
+    using table = __details::compiled_table<Table>;
+
+    static_assert(!table::has_predicates,
+                  "Predicate guards can not be checked atomically");
+    using cell_t = __details::least_uint_t<table::cell_count - 1>;
+
+    static constexpr std::size_t guard_count = table::guard_count;
+
+    static_assert(std::atomic<cell_t>::is_always_lock_free,
+                  "The cell of the machine must be lock-free");
+
+    std::atomic<cell_t> m_cell;
+
+    /*
+     * Moves the cell by the event with index event_id; returns the index of
+     * the performed transition or no_transition.
+     */
+    inline std::size_t transit(std::size_t event_id) noexcept {
+      cell_t cell = m_cell.load(std::memory_order_acquire);
+      for (;;) {
+        const auto tr = table::lookup(event_id, cell);
+        if (tr == table::no_transition) return tr;
+        const auto next = static_cast<cell_t>(
+            table::targets[tr] * guard_count + cell % guard_count);
+        if (m_cell.compare_exchange_weak(cell, next, std::memory_order_acq_rel,
+                                         std::memory_order_acquire))
+          return tr;
+      }
+    }
+
+  public:
+    /**
+     * @brief Runtime index of the event Event, that is accepted by
+     * `dispatch`
+     */
+    template <class Event>
+    static constexpr std::size_t event_id = table::template event_index<Event>;
+
+    inline atomic_state_machine() noexcept
+        : m_cell(static_cast<cell_t>(table::template guard_index<none>)) {}
+
+    atomic_state_machine(const atomic_state_machine&) = delete;
+    atomic_state_machine& operator=(const atomic_state_machine&) = delete;
+
+    /**
+     * @brief Pass an event to a State Machine
+     *
+     * @tparam Event event
+     * @param args arguments of the transition action
+     *
+     * @return true, if this call performed a transition
+     */
+    template <typename Event, typename... Args>
+    bool event(Args&&... args) {
+      if constexpr (table::template has_event<Event>)
+        return dispatch(event_id<Event>, std::forward<Args>(args)...);
+      else
+        return false;
+    }
+
+    /**
+     * @brief Pass an event to a State Machine by its runtime index
+     *
+     * @return true, if this call performed a transition
+     */
+    template <typename... Args>
+    bool dispatch(std::size_t event_id, Args&&... args) {
+      if (event_id >= table::event_count) return false;
+      const std::size_t tr = transit(event_id);
+      if (tr == table::no_transition) return false;
+      __details::action_thunks<Table, Args...>::value[tr](
+          std::forward<Args>(args)...);
+      return true;
+    }
+
+    /**
+     * @brief Change current guard
+     *
+     * @tparam Guard next guard
+     */
+    template <class Guard>
+    inline void guard() noexcept {
+      if constexpr (__details::static_check_contains<
+                        Guard, typename Table::guard_collection>()) {
+        constexpr std::size_t guard = table::template guard_index<Guard>;
+        cell_t cell = m_cell.load(std::memory_order_relaxed);
+        while (!m_cell.compare_exchange_weak(
+            cell, static_cast<cell_t>(cell - cell % guard_count + guard),
+            std::memory_order_acq_rel, std::memory_order_relaxed)) {}
+      }
+    }
+
+    /**
+     * @brief Index of the current state in the state collection of the
+     * table
+     */
+    inline std::size_t state() const noexcept {
+      return m_cell.load(std::memory_order_acquire) / guard_count;
+    }
+
+    /**
+     * @brief Checks, if the current state is State
+     */
+    template <class State>
+    inline bool is_in() const noexcept {
+      return state() == table::template state_index<State>;
+    }
+  };
+
+} // namespace pure
+
+#endif
@@ -0,0 +1,297 @@
+/**
+ * @file fleet.hpp
+ *
+ * File that contains a fleet of keyed State Machines, which are sharded
+ * across worker threads.
+ */
+#ifndef PUREFSM_FLEET_HPP
+#define PUREFSM_FLEET_HPP
+
+#include "fsm.hpp"
+#include "queue.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace pure {
+
+  /**
+   * @brief Fleet of State Machines, identified by keys and sharded across
+   * worker threads
+   *
+   * @tparam Table transition_table
+   * @tparam Key key of a machine, e.g. a session id
+   * @tparam Payload type of a value, that is posted with an event and is
+   * passed to the transition action; `none` if events carry no value
+   * @tparam QueueCapacity capacity of every event queue, a power of two
+   * @tparam Hash hash function of keys
+   *
+   * Machines are partitioned into shards by the hash of their keys, one
+   * shard per worker thread. A shard keeps the state and the guard of every
+   * its machine as one integer in a contiguous array, and receives events
+   * through one single-producer queue per producer, so producers never
+   * contend with each other.
+   *
+   * A worker drains its own shard in batches of up to `batch_size` events.
+   * When its shard is empty, it takes a whole batch from the most loaded
+   * shard, if that shard holds at least `batch_size` events and is not
+   * drained by another worker at the moment. A shard is drained by one
+   * worker at a time, so events of one machine are processed in the order
+   * they were posted by a producer.
+   *
+   * A machine is created, in its initial state, by the first event posted
+   * for its key. Transition actions are called by the workers with the
+   * payload of the event.
+   */
+  template <class Table, class Key, class Payload = none,
+            std::size_t QueueCapacity = 1024, class Hash = std::hash<Key>>
+  class machine_fleet {
+  public:
+    /** @brief Maximal number of events, drained from a shard at once */
+    static constexpr std::size_t batch_size =
+        QueueCapacity < 256 ? QueueCapacity : 256;
+
+    /**
+     * @brief Runtime index of the event Event
+     */
+    template <class Event>
+    static constexpr std::size_t event_id =
+        __details::compiled_table<Table>::template event_index<Event>;
+
+  private:
+    using table = __details::compiled_table<Table>;
+
+    static_assert(!table::has_predicates,
+                  "Fleet machines do not support predicate guards");
+    using cell_t = __details::least_uint_t<table::cell_count - 1>;
+
+    static constexpr std::size_t guard_count = table::guard_count;
+
+    struct record {
+      Key key;
+      std::uint32_t event;
+      Payload payload;
+    };
+
+    using queue_t = __details::spsc_queue<record, QueueCapacity>;
+
+    struct shard {
+      alignas(64) std::atomic<bool> busy {false};
+      std::unique_ptr<queue_t[]> queues;
+      std::vector<cell_t> cells;
+      std::unordered_map<Key, std::size_t, Hash> index;
+      std::size_t transitions = 0;
+    };
+
+    std::size_t m_producers;
+    std::size_t m_shard_count;
+    std::unique_ptr<shard[]> m_shards;
+    std::atomic<bool> m_stop {false};
+    std::vector<std::thread> m_workers;
+
+    inline std::size_t shard_of(const Key& key) const noexcept {
+      // Hashes of integers are often the integers themselves, so they are
+      // mixed before taking the shard.
+      const std::uint64_t hash =
+          static_cast<std::uint64_t>(Hash {}(key)) * 0x9E3779B97F4A7C15ull;
+      return static_cast<std::size_t>(hash >> 32) % m_shard_count;
+    }
+
+    inline bool acquire(shard& s) noexcept {
+      return !s.busy.load(std::memory_order_relaxed) &&
+             !s.busy.exchange(true, std::memory_order_acquire);
+    }
+
+    inline void release(shard& s) noexcept {
+      s.busy.store(false, std::memory_order_release);
+    }
+
+    inline void apply(shard& s, record& rec) {
+      auto [it, inserted] = s.index.try_emplace(rec.key, s.cells.size());
+      if (inserted)
+        s.cells.push_back(
+            static_cast<cell_t>(table::template guard_index<none>));
+
+      cell_t& cell = s.cells[it->second];
+      const auto tr = table::lookup(rec.event, cell);
+      if (tr == table::no_transition) return;
+      cell = static_cast<cell_t>(table::targets[tr] * guard_count +
+                                 cell % guard_count);
+      ++s.transitions;
+      if constexpr (std::is_same_v<Payload, none>)
+        __details::action_thunks<Table>::value[tr]();
+      else
+        __details::action_thunks<Table, Payload&>::value[tr](rec.payload);
+    }
+
+    /*
+     * Drains up to batch_size events from the shard, that is acquired by the
+     * caller.
+     */
+    std::size_t drain(shard& s) {
+      record rec;
+      std::size_t count = 0;
+      for (std::size_t p = 0; p < m_producers && count < batch_size; ++p)
+        while (count < batch_size && s.queues[p].pop(rec)) {
+          apply(s, rec);
+          ++count;
+        }
+      return count;
+    }
+
+    inline std::size_t backlog(const shard& s) const noexcept {
+      std::size_t size = 0;
+      for (std::size_t p = 0; p < m_producers; ++p) size += s.queues[p].size();
+      return size;
+    }
+
+    /*
+     * Takes one batch from the most loaded shard besides the own one.
+     */
+    std::size_t steal(std::size_t own) {
+      std::size_t victim = own;
+      std::size_t most = batch_size - 1;
+      for (std::size_t idx = 0; idx < m_shard_count; ++idx) {
+        if (idx == own) continue;
+        const std::size_t size = backlog(m_shards[idx]);
+        if (size > most) {
+          most = size;
+          victim = idx;
+        }
+      }
+      if (victim == own || !acquire(m_shards[victim])) return 0;
+      const std::size_t count = drain(m_shards[victim]);
+      release(m_shards[victim]);
+      return count;
+    }
+
+    void run(std::size_t own) {
+      shard& s = m_shards[own];
+      for (;;) {
+        std::size_t count = 0;
+        bool drained = false;
+        if (acquire(s)) {
+          count = drain(s);
+          release(s);
+          drained = true;
+        }
+        if (count) continue;
+        if (drained && m_stop.load(std::memory_order_acquire) &&
+            backlog(s) == 0)
+          return;
+        if (!steal(own)) std::this_thread::yield();
+      }
+    }
+
+  public:
+    /**
+     * @brief Constructs the fleet and starts its workers
+     *
+     * @param workers number of worker threads and shards
+     * @param producers number of producers; every producer posts events with
+     * its own index from one thread at a time
+     */
+    machine_fleet(std::size_t workers, std::size_t producers)
+        : m_producers(producers), m_shard_count(workers ? workers : 1),
+          m_shards(new shard[m_shard_count]) {
+      for (std::size_t idx = 0; idx < m_shard_count; ++idx)
+        m_shards[idx].queues.reset(new queue_t[m_producers]);
+      for (std::size_t idx = 0; idx < m_shard_count; ++idx)
+        m_workers.emplace_back([this, idx] { run(idx); });
+    }
+
+    machine_fleet(const machine_fleet&) = delete;
+    machine_fleet& operator=(const machine_fleet&) = delete;
+
+    inline ~machine_fleet() { stop(); }
+
+    /**
+     * @brief Post an event to the machine with the key
+     *
+     * @param producer index of the producer
+     * @param key key of the machine
+     * @param event runtime index of the event
+     * @param payload value, passed to the transition action
+     *
+     * @return false, if the queue of the producer to the shard of the key is
+     * full, or if the producer or the event is out of range; the event is
+     * not posted then
+     */
+    inline bool post(std::size_t producer, const Key& key, std::size_t event,
+                     const Payload& payload = {}) {
+      if (producer >= m_producers || event >= table::event_count)
+        return false;
+      return m_shards[shard_of(key)].queues[producer].push(
+          record {key, static_cast<std::uint32_t>(event), payload});
+    }
+
+    /**
+     * @brief Post an event to the machine with the key
+     *
+     * @return false, if the queue is full or the producer is out of range;
+     * the event is not posted then
+     */
+    template <class Event>
+    inline bool post(std::size_t producer, const Key& key,
+                     const Payload& payload = {}) {
+      static_assert(table::template has_event<Event>,
+                    "Event is not in the table");
+      return post(producer, key, event_id<Event>, payload);
+    }
+
+    /**
+     * @brief Processes the posted events and stops the workers
+     *
+     * Producers must not post events after the call.
+     */
+    void stop() {
+      m_stop.store(true, std::memory_order_release);
+      for (auto& worker : m_workers)
+        if (worker.joinable()) worker.join();
+    }
+
+    /**
+     * @brief Number of machines; may be called only after `stop`
+     */
+    std::size_t size() const noexcept {
+      std::size_t result = 0;
+      for (std::size_t idx = 0; idx < m_shard_count; ++idx)
+        result += m_shards[idx].cells.size();
+      return result;
+    }
+
+    /**
+     * @brief Number of performed transitions; may be called only after
+     * `stop`
+     */
+    std::size_t transitions() const noexcept {
+      std::size_t result = 0;
+      for (std::size_t idx = 0; idx < m_shard_count; ++idx)
+        result += m_shards[idx].transitions;
+      return result;
+    }
+
+    /**
+     * @brief Checks, if the machine with the key exists and is in the state
+     * State; may be called only after `stop`
+     */
+    template <class State>
+    bool is_in(const Key& key) const {
+      const shard& s = m_shards[shard_of(key)];
+      const auto it = s.index.find(key);
+      return it != s.index.end() &&
+             s.cells[it->second] / guard_count ==
+                 table::template state_index<State>;
+    }
+  };
+
+} // namespace pure
+
+#endif
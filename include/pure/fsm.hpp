@@ -6,7 +6,11 @@
 #ifndef PURE_FSM
 #define PURE_FSM
 
+#include <array>
 #include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iterator>
 
 /**
  * @bug Clangd can't find `<type_pack.hpp>` header, but can find it by
@@ -55,6 +59,9 @@ namespace pure {
     template <class Guard>
     struct is_logical_guard;
 
+    template <class Guard>
+    struct is_predicate_guard;
+
     template <typename T>
     struct unpack {};
 
@@ -66,56 +73,592 @@ namespace pure {
     template <class GuardPack>
     struct unpack_guards;
 
-    template <class Source, class Event, class GuardPack>
-    struct tr_cond {};
+    /*
+     * The pack algorithms below are built on pack expansions, index
+     * sequences and constexpr arrays instead of recursion over the pack, so
+     * the depth of the instantiation does not depend on the size of the
+     * transition table, and the number of instantiations grows linearly with
+     * it. Types are compared by constexpr keys instead of std::is_same with
+     * every other type of the pack.
+     */
 
-    template <class TrPack>
-    struct unpack_trs {
-      using type = tp::empty_pack;
+    /*
+     * type_key is the FNV-1a hash of the signature of the function, that
+     * names the type T on the most of the compilers. The address of
+     * type_key<T> identifies T, so the types with equal hashes are still
+     * told apart.
+     */
+    template <class T>
+    constexpr std::uint64_t type_key() noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+      const char* sig = __PRETTY_FUNCTION__;
+#elif defined(_MSC_VER)
+      const char* sig = __FUNCSIG__;
+#else
+      const char* sig = "";
+#endif
+      std::uint64_t hash = 14695981039346656037u;
+      for (; *sig; ++sig) {
+        hash ^= static_cast<unsigned char>(*sig);
+        hash *= 1099511628211u;
+      }
+      return hash;
+    }
+
+    using type_id_t = std::uint64_t (*)() noexcept;
+
+    /*
+     * key_table is an open addressing hash table of the positions of N
+     * keys, that holds only the first position of every item; a slot holds
+     * a position plus one, or zero, if it is free.
+     */
+    template <std::size_t N>
+    struct key_table {
+      static constexpr std::size_t bits = [] {
+        std::size_t bits = 1;
+        while ((std::size_t(1) << bits) < 2 * N) ++bits;
+        return bits;
+      }();
+
+      static constexpr std::size_t mask = (std::size_t(1) << bits) - 1;
+
+      std::array<std::size_t, mask + 1> slots {};
+
+      /* Tells for every position, if it is the first one of its item */
+      std::array<bool, N> firsts {};
+
+      static constexpr std::size_t home(std::uint64_t key) noexcept {
+        return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15u) >>
+                                        (64 - bits));
+      }
+
+      /*
+       * Returns the first position of the item with the key, for which
+       * same(position) holds, or N.
+       */
+      template <class Same>
+      constexpr std::size_t find(std::uint64_t key, Same same) const noexcept {
+        for (std::size_t slot = home(key); slots[slot];
+             slot = (slot + 1) & mask)
+          if (same(slots[slot] - 1)) return slots[slot] - 1;
+        return N;
+      }
+    };
+
+    /*
+     * Builds the key_table of the keys; the positions lhs and rhs hold the
+     * same item, if same(lhs, rhs), which implies equal keys.
+     */
+    template <std::size_t N, class Same>
+    constexpr key_table<N>
+    make_key_table(const std::array<std::uint64_t, N>& keys,
+                   Same same) noexcept {
+      key_table<N> table {};
+      for (std::size_t pos = 0; pos < N; ++pos) {
+        std::size_t slot = table.home(keys[pos]);
+        bool first = true;
+        for (; first && table.slots[slot]; slot = (slot + 1) & table.mask)
+          first = !same(table.slots[slot] - 1, pos);
+        if (first) table.slots[slot] = pos + 1;
+        table.firsts[pos] = first;
+      }
+      return table;
+    }
+
+    /*
+     * Mixes the keys and their number into the hash, FNV-1a over 64-bit
+     * words with an extra shift, so the high bits of a key reach the low
+     * bits of the hash.
+     */
+    template <std::size_t N>
+    constexpr std::uint64_t
+    mix_keys(std::uint64_t hash,
+             const std::array<std::uint64_t, N>& keys) noexcept {
+      for (std::size_t idx = 0; idx <= N; ++idx) {
+        hash ^= idx < N ? keys[idx] : N;
+        hash *= 1099511628211u;
+        hash ^= hash >> 29;
+      }
+      return hash;
+    }
+
+    /*
+     * type_keys holds the hash table of the types of a pack, so a type is
+     * found in the pack without a comparison with every type of the pack.
+     */
+    template <typename... Ts>
+    struct type_keys {
+      static constexpr std::size_t size = sizeof...(Ts);
+
+      static constexpr std::array<std::uint64_t, size> keys = {
+          type_key<Ts>()...};
+
+      static constexpr std::array<type_id_t, size> ids = {&type_key<Ts>...};
+
+      static constexpr key_table<size> table =
+          make_key_table(keys, [](std::size_t lhs, std::size_t rhs) {
+            return ids[lhs] == ids[rhs];
+          });
+
+      /*
+       * Returns the first position of the type with the key and the
+       * identifier, or the size of the pack.
+       */
+      static constexpr std::size_t find(std::uint64_t key,
+                                        type_id_t id) noexcept {
+        return table.find(key,
+                          [id](std::size_t pos) { return ids[pos] == id; });
+      }
+    };
+
+    template <class Pack>
+    struct pack_keys;
+
+    template <typename... Ts>
+    struct pack_keys<tp::type_pack<Ts...>> {
+      using type = type_keys<Ts...>;
+    };
+
+    /*
+     * keys_of is the type_keys of the pack. The positions of many types are
+     * found by calls to keys_of<Pack>::find: a function template per type,
+     * parameterized by the whole pack, would cost an instantiation with a
+     * name as long as the pack for every type.
+     */
+    template <class Pack>
+    using keys_of = typename pack_keys<Pack>::type;
+
+    /*
+     * index_of returns the first position of the type T in the pack, or the
+     * size of the pack, if T does not appear in it.
+     */
+    template <class T, typename... Ts>
+    constexpr std::size_t index_of(tp::type_pack<Ts...>) noexcept {
+      return type_keys<Ts...>::find(type_key<T>(), &type_key<T>);
+    }
+
+    /*
+     * indexed tags the type T with its position I in a pack. indexer
+     * derives from indexed<I, T> for every type of the pack, so the type at
+     * a position is deduced from the bases of the indexer.
+     */
+    template <std::size_t I, class T>
+    struct indexed {
+      using type = T;
+    };
+
+    template <class Seq, typename... Ts>
+    struct indexer_impl;
+
+    template <std::size_t... Is, typename... Ts>
+    struct indexer_impl<std::index_sequence<Is...>, Ts...>
+        : indexed<Is, Ts>... {};
+
+    template <typename... Ts>
+    using indexer = indexer_impl<std::index_sequence_for<Ts...>, Ts...>;
+
+    template <std::size_t I, class T>
+    indexed<I, T> pick(const indexed<I, T>*);
+
+    template <std::size_t I, typename... Ts>
+    using pick_t = typename decltype(pick<I>(
+        static_cast<const indexer<Ts...>*>(nullptr)))::type;
+
+    template <class Seen, class Pack>
+    struct merge_unique;
+
+    /*
+     * merge_unique_t appends to the pack Seen of distinct types the types of
+     * Pack, that are not in Seen, in the order of their first appearance.
+     * The types are picked out of Pack only if some, but not all of them are
+     * appended.
+     */
+    template <class Seen, class Pack>
+    using merge_unique_t = typename merge_unique<Seen, Pack>::type;
+
+    template <typename... Ss, typename... Ts>
+    struct merge_unique<tp::type_pack<Ss...>, tp::type_pack<Ts...>> {
+    private:
+      static constexpr std::size_t offset = sizeof...(Ss);
+
+      static constexpr auto& firsts = type_keys<Ss..., Ts...>::table.firsts;
+
+      static constexpr std::size_t count = [] {
+        std::size_t count = 0;
+        for (std::size_t pos = offset; pos < firsts.size(); ++pos)
+          count += firsts[pos];
+        return count;
+      }();
+
+      static constexpr std::array<std::size_t, count> positions = [] {
+        std::array<std::size_t, count> positions {};
+        std::size_t idx = 0;
+        for (std::size_t pos = offset; pos < firsts.size(); ++pos)
+          if (firsts[pos]) positions[idx++] = pos - offset;
+        return positions;
+      }();
+
+      template <std::size_t... Is>
+      static tp::type_pack<Ss..., pick_t<positions[Is], Ts...>...>
+          append(std::index_sequence<Is...>);
+
+      static auto merge() {
+        if constexpr (count == 0)
+          return tp::type_pack<Ss...> {};
+        else if constexpr (count == sizeof...(Ts))
+          return tp::type_pack<Ss..., Ts...> {};
+        else
+          return decltype(append(std::make_index_sequence<count> {})) {};
+      }
+
+    public:
+      using type = decltype(merge());
     };
 
-    template <class Tr, class... Trs>
-    struct unpack_trs<tp::type_pack<Tr, Trs...>> {
-      using source_t = typename Tr::source_t;
-      using event_t = typename Tr::event_t;
-      using guard_t = typename Tr::guard_t;
-      using tr_t = tr_cond<source_t, event_t, guard_t>;
+    /*
+     * unique_t is the pack of the distinct types of Pack in the order of
+     * their first appearance.
+     */
+    template <class Pack>
+    using unique_t = merge_unique_t<tp::empty_pack, Pack>;
+
+    /*
+     * join_t is the concatenation of the packs Packs... It is used only for
+     * the few distinct guards of a table.
+     */
+    template <typename... Ts>
+    struct joiner {
+      using type = tp::type_pack<Ts...>;
+
+      template <typename... Us>
+      joiner<Ts..., Us...> operator+(tp::type_pack<Us...>) const;
+    };
+
+    template <typename... Packs>
+    struct join {
+      using type = typename decltype((joiner<> {} + ... + Packs {}))::type;
+    };
+
+    template <typename... Packs>
+    using join_t = typename join<Packs...>::type;
+
+    /*
+     * Tells, if no two transitions have the same source, event and guard.
+     * The transitions are compared by the positions of these types in the
+     * collections of the table.
+     */
+    template <class States, class Events, class Guards, typename... Ts>
+    constexpr bool distinct_transitions(tp::type_pack<Ts...>) noexcept {
+      using state_keys = keys_of<States>;
+      using event_keys = keys_of<Events>;
+      using guard_keys = keys_of<Guards>;
+
+      const std::array<std::uint64_t, sizeof...(Ts)> keys = {
+          (state_keys::find(type_key<typename Ts::source_t>(),
+                            &type_key<typename Ts::source_t>) *
+               Events::size() +
+           event_keys::find(type_key<typename Ts::event_t>(),
+                            &type_key<typename Ts::event_t>)) *
+              Guards::size() +
+          guard_keys::find(type_key<typename Ts::guard_t>(),
+                           &type_key<typename Ts::guard_t>)...};
+      const auto table =
+          make_key_table(keys, [&keys](std::size_t lhs, std::size_t rhs) {
+            return keys[lhs] == keys[rhs];
+          });
+      for (bool first : table.firsts)
+        if (!first) return false;
+      return true;
+    }
+
+    struct composite_base {};
+
+    template <class State>
+    inline constexpr bool is_composite_v =
+        std::is_base_of_v<composite_base, State>;
+
+    /*
+     * entry_t is the leaf state, that is entered by a transition into the
+     * state State: State itself, or the initial state of its nested table,
+     * that is entered the same way.
+     */
+    template <class State, bool = is_composite_v<State>>
+    struct entry {
+      using type = State;
+    };
+
+    template <class State>
+    using entry_t = typename entry<State>::type;
+
+    template <class State>
+    struct entry<State, true> {
+      using first = std::conditional_t<
+          std::is_void_v<typename State::initial>,
+          typename tp::at_t<0, typename State::sub_table::raw_transitions>::
+              source_t,
+          typename State::initial>;
+
+      using type = entry_t<first>;
+    };
+
+    /*
+     * leaves_t is the pack of the leaf states of the state State: the
+     * states of its nested table, that is already flattened, or State.
+     */
+    template <class State, bool = is_composite_v<State>>
+    struct leaves {
+      using type = tp::type_pack<State>;
+    };
+
+    template <class State>
+    struct leaves<State, true> {
+      using type = typename State::sub_table::state_collection;
+    };
+
+    /*
+     * inherit_t replicates the transition Tr for every leaf of its source,
+     * with the entry state of its target.
+     */
+    template <class Tr, class Leaves>
+    struct inherit;
+
+    template <class Tr, typename... Ls>
+    struct inherit<Tr, tp::type_pack<Ls...>> {
+      using type = tp::type_pack<
+          transition<Ls, typename Tr::event_t,
+                     entry_t<typename Tr::target_t>, typename Tr::action_t,
+                     typename Tr::guard_t>...>;
+    };
+
+    template <class Tr>
+    using inherit_t =
+        typename inherit<Tr, typename leaves<typename Tr::source_t>::type>::
+            type;
+
+    template <class State>
+    using composite_pack_t =
+        std::conditional_t<is_composite_v<State>, tp::type_pack<State>,
+                           tp::empty_pack>;
+
+    template <class Composites>
+    struct nested_transitions;
+
+    template <typename... Cs>
+    struct nested_transitions<tp::type_pack<Cs...>> {
+      using type = join_t<typename Cs::sub_table::transitions...>;
+
+    private:
+      /* A leaf of two composites would inherit the transitions of both */
+      using leaf_pack = join_t<typename leaves<Cs>::type...>;
+
+      static_assert(unique_t<leaf_pack>::size() == leaf_pack::size(),
+                    "Composite states must not share leaf states");
+    };
+
+    template <class Source, class Event, class Guard>
+    struct transition_key {};
+
+    /*
+     * override_t is the pack of the transitions of the nested tables
+     * Nested, followed by the inherited transitions Inherited, that no
+     * nested transition with the same source, event and guard overrides.
+     * Inherited transitions with the same key are all kept, so duplicates
+     * of the table itself are still reported.
+     */
+    template <class Nested, class Inherited>
+    struct override;
+
+    template <typename... Ns, typename... Is>
+    struct override<tp::type_pack<Ns...>, tp::type_pack<Is...>> {
+    private:
+      using keys = type_keys<
+          transition_key<typename Ns::source_t, typename Ns::event_t,
+                         typename Ns::guard_t>...,
+          transition_key<typename Is::source_t, typename Is::event_t,
+                         typename Is::guard_t>...>;
+
+      static constexpr std::size_t offset = sizeof...(Ns);
+
+      static constexpr bool kept(std::size_t pos) noexcept {
+        return keys::find(keys::keys[pos], keys::ids[pos]) >= offset;
+      }
+
+      static constexpr std::size_t count = [] {
+        std::size_t count = 0;
+        for (std::size_t pos = offset; pos < keys::size; ++pos)
+          count += kept(pos);
+        return count;
+      }();
+
+      static constexpr std::array<std::size_t, count> positions = [] {
+        std::array<std::size_t, count> positions {};
+        std::size_t idx = 0;
+        for (std::size_t pos = offset; pos < keys::size; ++pos)
+          if (kept(pos)) positions[idx++] = pos - offset;
+        return positions;
+      }();
+
+      template <std::size_t... Ps>
+      static tp::type_pack<Ns..., pick_t<positions[Ps], Is...>...>
+          pick(std::index_sequence<Ps...>);
+
+      static auto merge() {
+        if constexpr (count == sizeof...(Is))
+          return tp::type_pack<Ns..., Is...> {};
+        else
+          return decltype(pick(std::make_index_sequence<count> {})) {};
+      }
+
+    public:
+      using type = decltype(merge());
+    };
+
+    /*
+     * flatten_t is the pack of the transitions of a table without composite
+     * states: the transitions of the nested tables go first, then the
+     * transitions of the table, replicated for every leaf of their sources.
+     * Tables without composite states are kept as they are.
+     *
+     * The nested transitions go first, so `initial` holds the entry state of
+     * the first source of the table, that is the initial state.
+     */
+    template <bool Nested, typename... Ts>
+    struct flatten {
+      using type = tp::type_pack<Ts...>;
+      using initial = tp::empty_pack;
+    };
+
+    template <typename... Ts>
+    struct flatten<true, Ts...> {
+      using composites =
+          unique_t<join_t<composite_pack_t<typename Ts::source_t>...,
+                          composite_pack_t<typename Ts::target_t>...>>;
 
       using type =
-          tp::concatenate_t<tp::just_type<tr_t>,
-                            typename unpack_trs<tp::type_pack<Trs...>>::type>;
+          typename override<typename nested_transitions<composites>::type,
+                            join_t<inherit_t<Ts>...>>::type;
+
+      using initial = tp::type_pack<
+          entry_t<typename tp::at_t<0, tp::type_pack<Ts...>>::source_t>>;
+    };
+
+    template <typename... Ts>
+    using flatten_of = flatten<(false || ... ||
+                                (is_composite_v<typename Ts::source_t> ||
+                                 is_composite_v<typename Ts::target_t>)),
+                               Ts...>;
+
+    template <class Transitions, class Initial>
+    struct table_collections;
+
+    template <typename... Ts, class Initial>
+    struct table_collections<tp::type_pack<Ts...>, Initial> {
+      /** @cond undocumented */
+      using transitions = tp::type_pack<Ts...>;
+
+      using sources = tp::type_pack<typename Ts::source_t...>;
+      using events = tp::type_pack<typename Ts::event_t...>;
+      using targets = tp::type_pack<typename Ts::target_t...>;
+      using transition_guards =
+          __details::unique_t<tp::type_pack<typename Ts::guard_t...>>;
+      using guards_raw =
+          tp::concatenate_t<transition_guards, tp::just_type<none>>;
+      using guards = typename __details::unpack_guards<guards_raw>::type;
+
+      using states = tp::concatenate_t<sources, targets>;
+
+      // Targets mostly repeat the sources, so they are merged separately
+      using state_collection = __details::merge_unique_t<
+          __details::unique_t<tp::concatenate_t<Initial, sources>>, targets>;
+      using event_collection = __details::unique_t<events>;
+      using guard_collection = __details::unique_t<guards>;
+
+      using state_v = typename __details::unpack<state_collection>::type;
+      using event_v = typename __details::unpack<event_collection>::type;
+      using guard_v = typename __details::unpack<guard_collection>::type;
+      /** @endcond */
+
+    private:
+      static_assert(__details::distinct_transitions<state_collection,
+                                                    event_collection,
+                                                    transition_guards>(
+                        transitions {}),
+                    "Duplicated transitions");
     };
+
   } // namespace __details
 
+  /**
+   * @brief Transition table of a State Machine
+   *
+   * Composite states (see `composite`) are flattened at compile time: the
+   * table holds the transitions of their nested tables and, for every leaf
+   * state of a composite state, the transitions of the composite state. So
+   * a State Machine is always in a leaf state, and an event is dispatched
+   * by one lookup at any depth of nesting.
+   */
   template <typename... Ts>
-  struct transition_table {
+  struct transition_table
+      : __details::table_collections<
+            typename __details::flatten_of<Ts...>::type,
+            typename __details::flatten_of<Ts...>::initial> {
     /** @cond undocumented */
-    using transitions = tp::type_pack<Ts...>;
-
-    using sources = tp::type_pack<typename Ts::source_t...>;
-    using events = tp::type_pack<typename Ts::event_t...>;
-    using targets = tp::type_pack<typename Ts::target_t...>;
-    using guards_raw = tp::concatenate_t<tp::type_pack<typename Ts::guard_t...>,
-                                         tp::just_type<none>>;
-    using guards = typename __details::unpack_guards<guards_raw>::type;
-
-    using states = tp::concatenate_t<sources, targets>;
-
-    using state_collection = tp::unique_t<states>;
-    using event_collection = tp::unique_t<events>;
-    using guard_collection = tp::unique_t<guards>;
+    using raw_transitions = tp::type_pack<Ts...>;
+    /** @endcond */
+  };
 
-    using state_v = typename __details::unpack<state_collection>::type;
-    using event_v = typename __details::unpack<event_collection>::type;
-    using guard_v = typename __details::unpack<guard_collection>::type;
+  /**
+   * @brief Base of a composite state, that owns a nested transition table
+   *
+   * @tparam Table nested transition_table
+   * @tparam Initial state of the nested table, that is entered by a
+   * transition into the composite state; the source of the first transition
+   * of the nested table by default
+   *
+   * ```cpp
+   * using connected = pure::transition_table<
+   *     pure::tr<Handshake, Accepted, Ready, none, none>,
+   *     pure::tr<Ready, Data, Ready, OnData, none>>;
+   *
+   * struct Connected : pure::composite<connected> {};
+   *
+   * using table = pure::transition_table<
+   *     pure::tr<Idle, Connect, Connected, none, none>,
+   *     pure::tr<Connected, Drop, Idle, none, none>>;
+   * ```
+   *
+   * A transition from a composite state is inherited by all its leaf
+   * states, unless a nested table has a transition from the leaf by the
+   * same event and guard. A transition into a composite state enters its
+   * initial state. The composite state itself is never current.
+   */
+  template <class Table, class Initial = void>
+  struct composite : __details::composite_base {
+    /** @cond undocumented */
+    using sub_table = Table;
+    using initial = Initial;
     /** @endcond */
+  };
 
-  private:
-    using tr_conds = typename __details::unpack_trs<transitions>::type;
-    using test_t = tp::unique_t<tr_conds>;
+  /**
+   * @brief Layout of the dispatch table of a transition table
+   */
+  enum class dispatch_layout {
+    /** dense, unless the table is large and sparse */
+    automatic,
+    /** one entry per event and cell (state and guard) */
+    dense,
+    /** rows of the events overlap, every slot keeps its event */
+    displaced
+  };
 
-    static_assert(tp::is_equal<tr_conds, test_t>::value,
-                  "Duplicated transitions");
+  /**
+   * @brief Layout of the dispatch table of the table Table, automatic by
+   * default; specialize it to force a layout
+   */
+  template <class Table>
+  struct table_layout {
+    static constexpr dispatch_layout value = dispatch_layout::automatic;
   };
 
   namespace __details {
@@ -136,6 +679,522 @@ namespace pure {
       }
     }
 
+    /*
+     * least_uint_t is the smallest unsigned integer type that can hold
+     * the value Max.
+     */
+    template <std::size_t Max>
+    using least_uint_t = std::conditional_t<
+        Max <= UINT8_MAX, std::uint8_t,
+        std::conditional_t<
+            Max <= UINT16_MAX, std::uint16_t,
+            std::conditional_t<Max <= UINT32_MAX, std::uint32_t,
+                               std::uint64_t>>>;
+
+    /*
+     * guard_matrix holds the result of match_v for every guard of the guard
+     * collection against every distinct guard of the transitions, so the
+     * guard matching is done once per pair of guards instead of once per
+     * visited (state, guard, event) triple or per transition.
+     */
+    template <class Guard, class TargetPack>
+    struct guard_row;
+
+    template <class Guard, typename... Ts>
+    struct guard_row<Guard, tp::type_pack<Ts...>> {
+      static constexpr std::array<bool, sizeof...(Ts)> value = {
+          match_v<Guard, Ts>...};
+    };
+
+    template <class GuardPack, class TargetPack>
+    struct guard_matrix;
+
+    template <typename... Gs, class TargetPack>
+    struct guard_matrix<tp::type_pack<Gs...>, TargetPack> {
+      using row_t = std::array<bool, TargetPack::size()>;
+
+      static constexpr std::array<row_t, sizeof...(Gs)> value = {
+          guard_row<Gs, TargetPack>::value...};
+    };
+
+    /*
+     * compiled_table flattens a transition table into the index space used
+     * by the dispatch engine:
+     *
+     * - states, guards and events are numbered by their position in
+     *   state_collection, guard_collection and event_collection;
+     * - a cell is the pair (state, guard), numbered as state * G + guard;
+     * - the row of an event maps every cell to the index of the first
+     *   transition in the table that matches the cell and the event, or to
+     *   no_transition.
+     *
+     * So the lookup of a transition is one indexed load, whatever the size
+     * of the table is.
+     */
+    template <class Table>
+    struct compiled_table {
+      using transition_pack = typename Table::transitions;
+      using state_collection = typename Table::state_collection;
+      using event_collection = typename Table::event_collection;
+      using guard_collection = typename Table::guard_collection;
+
+      static constexpr std::size_t state_count = state_collection::size();
+      static constexpr std::size_t event_count = event_collection::size();
+      static constexpr std::size_t guard_count = guard_collection::size();
+      static constexpr std::size_t cell_count = state_count * guard_count;
+      static constexpr std::size_t transition_count = transition_pack::size();
+
+      using index_t = least_uint_t<transition_count>;
+
+      static constexpr index_t no_transition = transition_count;
+
+      template <class State>
+      static constexpr std::size_t state_index =
+          index_of<State>(state_collection {});
+
+      template <class Event>
+      static constexpr std::size_t event_index =
+          index_of<Event>(event_collection {});
+
+      template <class Guard>
+      static constexpr std::size_t guard_index =
+          index_of<Guard>(guard_collection {});
+
+    private:
+      using state_keys = keys_of<state_collection>;
+      using event_keys = keys_of<event_collection>;
+      using guard_keys = keys_of<typename Table::transition_guards>;
+
+      template <typename... Ts>
+      static constexpr std::array<std::size_t, sizeof...(Ts)>
+      make_sources(tp::type_pack<Ts...>) noexcept {
+        return {state_keys::find(type_key<typename Ts::source_t>(),
+                                 &type_key<typename Ts::source_t>)...};
+      }
+
+      template <typename... Ts>
+      static constexpr std::array<std::size_t, sizeof...(Ts)>
+      make_targets(tp::type_pack<Ts...>) noexcept {
+        return {state_keys::find(type_key<typename Ts::target_t>(),
+                                 &type_key<typename Ts::target_t>)...};
+      }
+
+      template <typename... Ts>
+      static constexpr std::array<std::size_t, sizeof...(Ts)>
+      make_events(tp::type_pack<Ts...>) noexcept {
+        return {event_keys::find(type_key<typename Ts::event_t>(),
+                                 &type_key<typename Ts::event_t>)...};
+      }
+
+      template <typename... Ts>
+      static constexpr std::array<std::size_t, sizeof...(Ts)>
+      make_guards(tp::type_pack<Ts...>) noexcept {
+        return {guard_keys::find(type_key<typename Ts::guard_t>(),
+                                 &type_key<typename Ts::guard_t>)...};
+      }
+
+      template <typename... Ts>
+      static constexpr std::array<bool, sizeof...(Ts)>
+      make_predicates(tp::type_pack<Ts...>) noexcept {
+        return {is_predicate_guard<typename Ts::guard_t>::value...};
+      }
+
+    public:
+      /** Source state index of every transition */
+      static constexpr std::array<std::size_t, transition_count> sources =
+          make_sources(transition_pack {});
+
+      /** Target state index of every transition */
+      static constexpr std::array<std::size_t, transition_count> targets =
+          make_targets(transition_pack {});
+
+      /** Event index of every transition */
+      static constexpr std::array<std::size_t, transition_count> events =
+          make_events(transition_pack {});
+
+      /** Tells for every transition, if its guard is a predicate */
+      static constexpr std::array<bool, transition_count> predicates =
+          make_predicates(transition_pack {});
+
+      /** Index of the guard of every transition in transition_guards */
+      static constexpr std::array<std::size_t, transition_count> guards =
+          make_guards(transition_pack {});
+
+      static constexpr bool has_predicates = [] {
+        for (bool predicate : predicates)
+          if (predicate) return true;
+        return false;
+      }();
+
+    private:
+      /* Tells, if the transition tr is allowed by the current guard */
+      static constexpr bool matches(std::size_t guard,
+                                    std::size_t tr) noexcept {
+        using matrix =
+            guard_matrix<guard_collection, typename Table::transition_guards>;
+        return matrix::value[guard][guards[tr]];
+      }
+
+      static constexpr std::array<index_t, event_count * cell_count>
+      make_rows() noexcept {
+        std::array<index_t, event_count * cell_count> rows {};
+        for (auto& tr : rows) tr = no_transition;
+
+        // Walk backwards, so the first matching transition of the table wins
+        for (std::size_t tr = transition_count; tr-- > 0;)
+          for (std::size_t guard = 0; guard < guard_count; ++guard)
+            if (matches(guard, tr))
+              rows[events[tr] * cell_count + sources[tr] * guard_count +
+                   guard] = static_cast<index_t>(tr);
+        return rows;
+      }
+
+    public:
+      /**
+       * Dense dispatch table: the rows of all events of the event
+       * collection, the row of an event starts at `event_index *
+       * cell_count`. It is kept in the program only by the dense layout.
+       */
+      static constexpr std::array<index_t, event_count * cell_count> rows =
+          make_rows();
+
+    private:
+      /*
+       * Calls visit(event, cell) for every entry of the dense table: the
+       * transitions are walked instead of the rows, as an entry holds the
+       * first transition, that matches its event and cell.
+       */
+      template <class Visit>
+      static constexpr void for_entries(Visit visit) noexcept {
+        for (std::size_t tr = 0; tr < transition_count; ++tr)
+          for (std::size_t guard = 0; guard < guard_count; ++guard) {
+            const std::size_t cell = sources[tr] * guard_count + guard;
+            if (rows[events[tr] * cell_count + cell] == tr)
+              visit(events[tr], cell);
+          }
+      }
+
+      static constexpr std::array<std::size_t, event_count> row_counts = [] {
+        std::array<std::size_t, event_count> counts {};
+        for_entries([&counts](std::size_t event, std::size_t) {
+          ++counts[event];
+        });
+        return counts;
+      }();
+
+    public:
+      /** Number of the pairs of an event and a cell with a transition */
+      static constexpr std::size_t entry_count = [] {
+        std::size_t count = 0;
+        for (std::size_t row : row_counts) count += row;
+        return count;
+      }();
+
+      static constexpr std::size_t dense_bytes = sizeof(rows);
+
+    private:
+      /*
+       * Tables up to 4 KiB stay dense, as well as the ones, whose entries
+       * fill more than a quarter of the rows: they would not shrink much.
+       */
+      static constexpr bool sparse =
+          dense_bytes > 4096 && entry_count * 4 < rows.size();
+
+      static constexpr dispatch_layout requested = table_layout<Table>::value;
+
+      static constexpr bool displace =
+          requested == dispatch_layout::displaced ||
+          (requested == dispatch_layout::automatic && sparse);
+
+      static constexpr std::size_t plan_entries = displace ? entry_count : 0;
+
+      /*
+       * The cells of the entries of the row of an event are cells[starts[
+       * event]] up to cells[starts[event + 1]].
+       */
+      struct displacement {
+        std::array<std::size_t, event_count + 1> starts {};
+        std::array<std::size_t, plan_entries> cells {};
+        std::array<std::size_t, event_count> offsets {};
+        std::size_t size = cell_count;
+      };
+
+      /*
+       * Row displacement: the rows are placed, the fullest first, into one
+       * array at the first offset, where their entries hit only free slots.
+       * A slot keeps the event of its entry, so a lookup of another event
+       * there sees no transition.
+       */
+      static constexpr displacement make_displacement() noexcept {
+        displacement plan {};
+        if constexpr (displace) {
+          std::array<std::size_t, event_count> order {};
+          for (std::size_t event = 0; event < event_count; ++event) {
+            plan.starts[event + 1] = plan.starts[event] + row_counts[event];
+            std::size_t pos = event;
+            for (; pos > 0 && row_counts[order[pos - 1]] < row_counts[event];
+                 --pos)
+              order[pos] = order[pos - 1];
+            order[pos] = event;
+          }
+          auto fill = plan.starts;
+          for_entries([&](std::size_t event, std::size_t cell) {
+            plan.cells[fill[event]++] = cell;
+          });
+
+          constexpr std::size_t slot_limit = rows.size() + cell_count;
+          std::array<std::uint64_t, slot_limit / 64 + 1> used {};
+          auto is_used = [&used](std::size_t pos) {
+            return (used[pos / 64] >> (pos % 64) & 1) != 0;
+          };
+          std::size_t free = 0;
+          for (std::size_t event : order) {
+            const std::size_t first = plan.starts[event];
+            const std::size_t last = plan.starts[event + 1];
+            if (first == last) continue;
+
+            std::size_t lowest = cell_count;
+            for (std::size_t idx = first; idx < last; ++idx)
+              lowest = plan.cells[idx] < lowest ? plan.cells[idx] : lowest;
+            std::size_t offset = free > lowest ? free - lowest : 0;
+            for (bool fits = false; !fits; offset += !fits) {
+              fits = true;
+              for (std::size_t idx = first; fits && idx < last; ++idx)
+                fits = !is_used(offset + plan.cells[idx]);
+            }
+            for (std::size_t idx = first; idx < last; ++idx) {
+              const std::size_t pos = offset + plan.cells[idx];
+              used[pos / 64] |= std::uint64_t(1) << (pos % 64);
+            }
+            while (is_used(free)) ++free;
+
+            plan.offsets[event] = offset;
+            if (offset + cell_count > plan.size)
+              plan.size = offset + cell_count;
+          }
+        }
+        return plan;
+      }
+
+      static constexpr displacement plan = make_displacement();
+
+      using owner_t = least_uint_t<event_count>;
+      using offset_t = least_uint_t<plan.size>;
+
+      struct slot {
+        index_t tr;
+        owner_t event;
+      };
+
+      static constexpr std::size_t displaced_bytes =
+          plan.size * sizeof(slot) + event_count * sizeof(offset_t);
+
+    public:
+      /** Layout of the dispatch table, see `table_layout` */
+      static constexpr dispatch_layout layout =
+          requested != dispatch_layout::automatic ? requested
+          : displace && displaced_bytes * 2 <= dense_bytes
+              ? dispatch_layout::displaced
+              : dispatch_layout::dense;
+
+    private:
+      static constexpr bool displaced = layout == dispatch_layout::displaced;
+
+      static constexpr std::array<slot, displaced ? plan.size : 0>
+      make_slots() noexcept {
+        std::array<slot, displaced ? plan.size : 0> slots {};
+        if constexpr (displaced) {
+          for (auto& entry : slots)
+            entry = {no_transition, static_cast<owner_t>(event_count)};
+          for (std::size_t event = 0; event < event_count; ++event)
+            for (std::size_t idx = plan.starts[event];
+                 idx < plan.starts[event + 1]; ++idx) {
+              const std::size_t cell = plan.cells[idx];
+              slots[plan.offsets[event] + cell] = {
+                  rows[event * cell_count + cell],
+                  static_cast<owner_t>(event)};
+            }
+        }
+        return slots;
+      }
+
+      static constexpr std::array<offset_t, displaced ? event_count : 0>
+      make_offsets() noexcept {
+        std::array<offset_t, displaced ? event_count : 0> offsets {};
+        for (std::size_t event = 0; event < offsets.size(); ++event)
+          offsets[event] = static_cast<offset_t>(plan.offsets[event]);
+        return offsets;
+      }
+
+    public:
+      /** Displaced dispatch table, empty for the dense layout */
+      static constexpr auto slots = make_slots();
+
+      /** Offsets of the rows of the events in the displaced table */
+      static constexpr auto offsets = make_offsets();
+
+      /** Size of the dispatch table in bytes */
+      static constexpr std::size_t dispatch_bytes =
+          displaced ? displaced_bytes : dense_bytes;
+
+      template <class Event>
+      static constexpr bool has_event = event_index<Event> < event_count;
+
+      /*
+       * Returns the index of the transition for the given event and cell,
+       * or no_transition. Event must be in the event collection.
+       */
+      static constexpr index_t lookup(std::size_t event,
+                                      std::size_t cell) noexcept {
+        if constexpr (displaced) {
+          const slot& entry = slots[offsets[event] + cell];
+          return entry.event == event ? entry.tr : no_transition;
+        } else
+          return rows[event * cell_count + cell];
+      }
+
+      /*
+       * fingerprint identifies the states and the guards of the table in
+       * their order, so a cell saved by one machine means the same state
+       * and guard to another one with the same fingerprint.
+       */
+      static constexpr std::uint64_t fingerprint =
+          mix_keys(mix_keys(14695981039346656037u,
+                            keys_of<state_collection>::keys),
+                   keys_of<guard_collection>::keys);
+
+    private:
+      static constexpr std::size_t candidate_count =
+          has_predicates ? transition_count * guard_count : 0;
+
+      /*
+       * For a transition tr and a guard, the next transition of the table
+       * after tr, that matches the source state and the event of tr and the
+       * guard, or no_transition. Only tables with predicate guards need it.
+       */
+      static constexpr std::array<index_t, candidate_count>
+      make_candidates() noexcept {
+        std::array<index_t, candidate_count> next {};
+        if constexpr (has_predicates) {
+          std::array<index_t, event_count * cell_count> first {};
+          for (auto& tr : first) tr = no_transition;
+
+          for (std::size_t tr = transition_count; tr-- > 0;)
+            for (std::size_t guard = 0; guard < guard_count; ++guard) {
+              const std::size_t idx = events[tr] * cell_count +
+                                      sources[tr] * guard_count + guard;
+              next[tr * guard_count + guard] = first[idx];
+              if (matches(guard, tr)) first[idx] = static_cast<index_t>(tr);
+            }
+        }
+        return next;
+      }
+
+    public:
+      /**
+       * Candidate chains: `candidates[tr * guard_count + guard]` is the
+       * transition, that is tried after tr, if the predicate of tr fails.
+       */
+      static constexpr std::array<index_t, candidate_count> candidates =
+          make_candidates();
+    };
+
+    /*
+     * action_thunks holds, for every transition of the table, a function,
+     * that calls the transition action with the arguments Args..., if the
+     * action is callable with them. It is used by the machines, that keep
+     * only the indices of states and do not log. Like the thunks of guards
+     * and states below, call_action is a free function template of a single
+     * action: it does not depend on the table, so it is instantiated once
+     * per action type and its symbol does not carry the whole table.
+     */
+    template <class Action, typename... Args>
+    void call_action(Args&&... args) {
+      if constexpr (std::is_invocable_v<Action, Args...>)
+        Action {}(std::forward<Args>(args)...);
+    }
+
+    template <class Table, typename... Args>
+    struct action_thunks {
+      template <typename... Ts>
+      static constexpr std::array<void (*)(Args&&...), sizeof...(Ts)>
+      make(tp::type_pack<Ts...>) noexcept {
+        return {&call_action<typename Ts::action_t, Args...>...};
+      }
+
+      static constexpr auto value = make(typename Table::transitions {});
+    };
+
+    /*
+     * predicate_thunks holds, for every transition of the table, a function,
+     * that evaluates the guard of the transition with the arguments Args...
+     * A tag guard always holds: it is already matched by the dispatch table.
+     * A predicate, that is not callable with the arguments, never holds.
+     */
+    template <class Guard, typename... Args>
+    bool call_predicate(Args&... args) {
+      if constexpr (!is_predicate_guard<Guard>::value)
+        return true;
+      else {
+        using predicate_t = typename Guard::predicate;
+        if constexpr (std::is_invocable_r_v<bool, predicate_t, Args&...>)
+          return predicate_t {}(args...);
+        else
+          return false;
+      }
+    }
+
+    template <class Table, typename... Args>
+    struct predicate_thunks {
+      template <typename... Ts>
+      static constexpr std::array<bool (*)(Args&...), sizeof...(Ts)>
+      make(tp::type_pack<Ts...>) noexcept {
+        return {&call_predicate<typename Ts::guard_t, Args...>...};
+      }
+
+      static constexpr auto value = make(typename Table::transitions {});
+    };
+
+    /*
+     * Returns the first transition of the candidate chain, that starts at
+     * tr, whose guard holds for the arguments, or no_transition. Predicates
+     * are evaluated in the order of the table and only until one holds, so
+     * a predicate runs only when its source state and event already
+     * matched.
+     */
+    template <class Table, typename... Args>
+    inline std::size_t check_predicates(std::size_t tr, std::size_t guard,
+                                        Args&... args) {
+      using table = compiled_table<Table>;
+      if constexpr (table::has_predicates) {
+        while (tr != table::no_transition && table::predicates[tr] &&
+               !predicate_thunks<Table, Args...>::value[tr](args...))
+          tr = table::candidates[tr * table::guard_count + guard];
+      }
+      return tr;
+    }
+
+    /*
+     * state_actions holds, for every state of the table, a function, that
+     * calls the state, if the state is callable with the arguments Args...
+     */
+    template <class State, class Logger, typename... Args>
+    void call_state(Logger& log, Args&&... args) {
+      log.template write<State>("Attempt to call an action for: ");
+      invoke(log, State {}, std::forward<Args>(args)...);
+    }
+
+    template <class Table, class Logger, typename... Args>
+    struct state_actions {
+      template <typename... Ss>
+      static constexpr std::array<void (*)(Logger&, Args&&...), sizeof...(Ss)>
+      make(tp::type_pack<Ss...>) noexcept {
+        return {&call_state<Ss, Logger, Args...>...};
+      }
+
+      static constexpr auto value = make(typename Table::state_collection {});
+    };
+
   } // namespace __details
 
   class empty_logger {
@@ -152,56 +1211,574 @@ namespace pure {
     inline void write(const char*) noexcept {}
   };
 
-  template <class Table, class Logger = empty_logger>
-  class state_machine {
+  class empty_metrics {};
+
+  /**
+   * @brief Queue policy of a State Machine without an internal event queue
+   */
+  class no_event_queue {};
+
+  /**
+   * @brief What an internal event queue does with an event, that is posted
+   * while the queue is full
+   */
+  enum class queue_overflow {
+    /** @brief The posted event is lost and `post` returns false */
+    reject,
+    /** @brief The oldest queued event is lost to make room for it */
+    drop_oldest,
+    /** @brief `std::terminate` is called */
+    terminate
+  };
+
+  /**
+   * @brief Queue policy of a State Machine with an internal event queue
+   *
+   * @tparam Capacity maximal number of queued events
+   * @tparam Overflow what happens to an event, posted into a full queue
+   *
+   * See `state_machine::post`.
+   */
+  template <std::size_t Capacity,
+            queue_overflow Overflow = queue_overflow::reject>
+  struct event_queue {
+    static_assert(Capacity > 0, "Event queue must hold at least one event");
+
+    /** @cond undocumented */
+    static constexpr std::size_t capacity = Capacity;
+    static constexpr queue_overflow overflow = Overflow;
+    /** @endcond */
+  };
+
+  /**
+   * @brief Current state and guard of a State Machine in a compact form
+   *
+   * See `state_machine::snapshot`
+   */
+  struct machine_snapshot {
+    /** @brief Fingerprint of the table of the machine */
+    std::uint64_t fingerprint;
+
+    /**
+     * @brief Index of the state times the number of guards plus the index
+     * of the guard
+     */
+    std::uint32_t cell;
+  };
+
+  /**
+   * @brief Compile time report of the dispatch table of the table Table
+   *
+   * See `table_layout`
+   */
+  template <class Table>
+  struct dispatch_report {
+    /** @brief Layout, that was chosen */
+    static constexpr dispatch_layout layout =
+        __details::compiled_table<Table>::layout;
+
+    /** @brief Size of the dispatch table in bytes */
+    static constexpr std::size_t bytes =
+        __details::compiled_table<Table>::dispatch_bytes;
+
+    /** @brief Size of the dense dispatch table in bytes */
+    static constexpr std::size_t dense_bytes =
+        __details::compiled_table<Table>::dense_bytes;
+
+    /** @brief Number of the pairs of an event and a cell with a transition */
+    static constexpr std::size_t entries =
+        __details::compiled_table<Table>::entry_count;
+  };
+
+  namespace __details {
+
+    template <class Logger>
+    inline constexpr bool is_empty_logger_v =
+        std::is_same_v<std::decay_t<Logger>, empty_logger>;
+
+    template <class Metrics>
+    inline constexpr bool is_empty_metrics_v =
+        std::is_same_v<std::decay_t<Metrics>, empty_metrics>;
+
+    template <class T, class Logger>
+    void write_type(Logger& log, const char* msg) {
+      log.template write<T>(msg);
+    }
+
+    /*
+     * type_writers holds, for every type of the pack, a function, that
+     * writes the message msg about the type to the logger.
+     */
+    template <class Logger, class Pack>
+    struct type_writers;
+
+    template <class Logger, typename... Ts>
+    struct type_writers<Logger, tp::type_pack<Ts...>> {
+      static constexpr std::array<void (*)(Logger&, const char*),
+                                  sizeof...(Ts)>
+          value = {&write_type<Ts, Logger>...};
+    };
+
+    template <class Pack>
+    struct all_empty;
+
+    template <typename... Ts>
+    struct all_empty<tp::type_pack<Ts...>>
+        : std::bool_constant<(std::is_empty_v<Ts> && ...)> {};
+
+    /*
+     * variant_storage keeps the current state and the current guard as
+     * objects of the state and guard variants of the table.
+     */
+    template <class T, class Variant>
+    void assign_default(Variant& variant) noexcept {
+      variant = T {};
+    }
+
+    template <class Table>
+    class variant_storage {
+    private:
+      using state_v = typename Table::state_v;
+      using guard_v = typename Table::guard_v;
+
+      state_v m_state;
+      guard_v m_guard;
+
+      template <class Variant, typename... Ts>
+      static constexpr std::array<void (*)(Variant&) noexcept, sizeof...(Ts)>
+      make_setters(tp::type_pack<Ts...>) noexcept {
+        return {&assign_default<Ts, Variant>...};
+      }
+
+    public:
+      inline variant_storage()
+          : m_state(tp::at_t<0, typename Table::state_collection> {}),
+            m_guard(none {}) {}
+
+      inline std::size_t state() const noexcept { return m_state.index(); }
+
+      inline std::size_t guard() const noexcept { return m_guard.index(); }
+
+      template <class State>
+      inline void set_state() {
+        m_state = State {};
+      }
+
+      inline void set_state(std::size_t idx) noexcept {
+        static constexpr auto setters =
+            make_setters<state_v>(typename Table::state_collection {});
+        setters[idx](m_state);
+      }
+
+      template <class Guard>
+      inline void set_guard() {
+        m_guard = Guard {};
+      }
+
+      inline void set_guard(std::size_t idx) noexcept {
+        static constexpr auto setters =
+            make_setters<guard_v>(typename Table::guard_collection {});
+        setters[idx](m_guard);
+      }
+    };
+
+    /*
+     * index_storage keeps only the indices of the current state and the
+     * current guard, each in the smallest unsigned type that fits. It is
+     * used when all states and guards are empty types, so an object of a
+     * state or a guard carries no information besides its type.
+     */
+    template <class Table>
+    class index_storage {
+    private:
+      using table = compiled_table<Table>;
+      using state_t = least_uint_t<table::state_count - 1>;
+      using guard_t = least_uint_t<table::guard_count - 1>;
+
+      state_t m_state;
+      guard_t m_guard;
+
+    public:
+      inline index_storage() noexcept
+          : m_state(0), m_guard(table::template guard_index<none>) {
+        // Indices of different widths are padded to the wider one
+        static_assert(sizeof(index_storage) ==
+                          2 * (sizeof(state_t) > sizeof(guard_t)
+                                   ? sizeof(state_t)
+                                   : sizeof(guard_t)),
+                      "Compact storage must hold only two indices");
+      }
+
+      inline std::size_t state() const noexcept { return m_state; }
+
+      inline std::size_t guard() const noexcept { return m_guard; }
+
+      template <class State>
+      inline void set_state() noexcept {
+        m_state = table::template state_index<State>;
+      }
+
+      inline void set_state(std::size_t idx) noexcept {
+        m_state = static_cast<state_t>(idx);
+      }
+
+      template <class Guard>
+      inline void set_guard() noexcept {
+        m_guard = table::template guard_index<Guard>;
+      }
+
+      inline void set_guard(std::size_t idx) noexcept {
+        m_guard = static_cast<guard_t>(idx);
+      }
+    };
+
+    template <class Table>
+    inline constexpr bool is_compact_v =
+        all_empty<typename Table::state_collection>::value &&
+        all_empty<typename Table::guard_collection>::value;
+
+    /*
+     * Storage policy of a state machine: index_storage if possible,
+     * variant_storage otherwise.
+     */
+    template <class Table>
+    using storage_t = std::conditional_t<is_compact_v<Table>,
+                                         index_storage<Table>,
+                                         variant_storage<Table>>;
+
+    /*
+     * logger_holder keeps a logger. Empty loggers are kept as a base class,
+     * so they do not take any space in the state machine.
+     */
+    template <class Logger,
+              bool = std::is_empty_v<Logger> && !std::is_final_v<Logger>>
+    class logger_holder {
+    private:
+      Logger m_logger;
+
+    public:
+      inline logger_holder() = default;
+
+      inline logger_holder(Logger logger) : m_logger(std::move(logger)) {}
+
+      inline Logger& logger() noexcept { return m_logger; }
+    };
+
+    template <class Logger>
+    class logger_holder<Logger, true> : private Logger {
+    public:
+      inline logger_holder() = default;
+
+      inline logger_holder(Logger logger) : Logger(std::move(logger)) {}
+
+      inline Logger& logger() noexcept { return *this; }
+    };
+
+    /*
+     * metrics_holder keeps a metrics policy the same way as logger_holder
+     * keeps a logger. The policy may be a reference.
+     */
+    template <class Metrics,
+              bool = std::is_empty_v<Metrics> && !std::is_final_v<Metrics>>
+    class metrics_holder {
+    private:
+      Metrics m_metrics;
+
+    public:
+      inline metrics_holder() = default;
+
+      inline metrics_holder(Metrics metrics)
+          : m_metrics(std::forward<Metrics>(metrics)) {}
+
+      inline std::remove_reference_t<Metrics>& get() noexcept {
+        return m_metrics;
+      }
+
+      inline const std::remove_reference_t<Metrics>& get() const noexcept {
+        return m_metrics;
+      }
+    };
+
+    template <class Metrics>
+    class metrics_holder<Metrics, true> : private Metrics {
+    public:
+      inline metrics_holder() = default;
+
+      inline metrics_holder(Metrics metrics) : Metrics(std::move(metrics)) {}
+
+      inline Metrics& get() noexcept { return *this; }
+
+      inline const Metrics& get() const noexcept { return *this; }
+    };
+
+    /*
+     * internal_queue is a ring of event indices with a static capacity,
+     * kept inside a state machine. `running` tells, that the machine is
+     * inside of an event call, so posted events are queued until the call
+     * drains them.
+     */
+    template <class Table, class Queue>
+    class internal_queue {
+    private:
+      using id_t = least_uint_t<compiled_table<Table>::event_count>;
+      using size_type = least_uint_t<Queue::capacity>;
+
+      std::array<id_t, Queue::capacity> m_ids {};
+      size_type m_head = 0;
+      size_type m_size = 0;
+      bool m_running = false;
+
+    public:
+      /*
+       * Resets the running flag and drops the rest of the queue at the end
+       * of the outermost event call, even if an action throws.
+       */
+      class run_scope {
+        internal_queue& m_queue;
+
+      public:
+        inline explicit run_scope(internal_queue& queue) noexcept
+            : m_queue(queue) {}
+
+        inline ~run_scope() {
+          m_queue.m_running = false;
+          m_queue.m_size = 0;
+        }
+      };
+
+      /*
+       * Marks the queue as running; returns false, if it already runs, so
+       * only the outermost call drains it.
+       */
+      inline bool begin() noexcept {
+        if (m_running) return false;
+        m_running = true;
+        return true;
+      }
+
+      inline bool running() const noexcept { return m_running; }
+
+      inline std::size_t size() const noexcept { return m_size; }
+
+      bool push(std::size_t id) noexcept {
+        if (m_size == Queue::capacity) {
+          if constexpr (Queue::overflow == queue_overflow::reject)
+            return false;
+          else if constexpr (Queue::overflow == queue_overflow::terminate)
+            std::terminate();
+          else {
+            m_head = static_cast<size_type>((m_head + 1) % Queue::capacity);
+            --m_size;
+          }
+        }
+        m_ids[(m_head + m_size) % Queue::capacity] = static_cast<id_t>(id);
+        ++m_size;
+        return true;
+      }
+
+      inline bool pop(std::size_t& id) noexcept {
+        if (m_size == 0) return false;
+        id = m_ids[m_head];
+        m_head = static_cast<size_type>((m_head + 1) % Queue::capacity);
+        --m_size;
+        return true;
+      }
+    };
+
+    /*
+     * queue_holder keeps the internal event queue of a state machine;
+     * without a queue it is empty and takes no space.
+     */
+    template <class Table, class Queue>
+    class queue_holder {
+    private:
+      internal_queue<Table, Queue> m_queue;
+
+    public:
+      static constexpr bool queued = true;
+
+      inline internal_queue<Table, Queue>& queue() noexcept { return m_queue; }
+
+      inline const internal_queue<Table, Queue>& queue() const noexcept {
+        return m_queue;
+      }
+    };
+
+    template <class Table>
+    class queue_holder<Table, no_event_queue> {
+    public:
+      static constexpr bool queued = false;
+    };
+
+  } // namespace __details
+
+  template <class Table, class Logger = empty_logger,
+            class Metrics = empty_metrics, class Queue = no_event_queue>
+  class state_machine : private __details::logger_holder<Logger>,
+                        private __details::metrics_holder<Metrics>,
+                        private __details::queue_holder<Table, Queue> {
   private:
-    using state_v = typename Table::state_v;
     using event_v = typename Table::event_v;
-    using guard_v = typename Table::guard_v;
     using transition_pack = typename Table::transitions;
     using guard_collection = typename Table::guard_collection;
 
-    static constexpr std::size_t m_tr_count = transition_pack::size();
+    using table = __details::compiled_table<Table>;
+    using storage_t = __details::storage_t<Table>;
+    using logger_t = Logger;
+    using holder_t = __details::logger_holder<Logger>;
+    using metrics_t = std::remove_reference_t<Metrics>;
+    using metrics_holder_t = __details::metrics_holder<Metrics>;
+    using queue_holder_t = __details::queue_holder<Table, Queue>;
+
+    static constexpr bool queued = queue_holder_t::queued;
 
-    state_v m_state;
-    guard_v m_guard;
+    static constexpr bool is_silent = __details::is_empty_logger_v<logger_t> &&
+                                      __details::is_empty_metrics_v<Metrics>;
 
-    using logger_t = Logger;
-    logger_t logger;
-
-    template <class State, class Event, class Guard, class Pack,
-              std::size_t Idx>
-    struct event_impl {
-      template <typename... Args>
-      inline void operator()(state_v&, Args&&...) noexcept {}
-    };
-
-    template <class State, class Event, class Guard, std::size_t Idx,
-              typename T, typename... Ts>
-    struct event_impl<State, Event, Guard, tp::type_pack<T, Ts...>, Idx> {
-      template <typename... Args>
-      inline void operator()(state_v& state, logger_t& log, Args&&... args) {
-        using state_t = typename T::source_t;
-        using event_t = typename T::event_t;
-        using guard_t = typename T::guard_t;
-        using target_t = typename T::target_t;
-        using action_t = typename T::action_t;
-
-        if constexpr (std::is_same_v<State, state_t> &&
-                      std::is_same_v<Event, event_t> &&
-                      __details::match_v<Guard, guard_t>) {
-          log.template write<target_t>("Change state to ");
-          state = target_t {};
-          __details::invoke(log, action_t {}, std::forward<Args>(args)...);
-        } else
-          event_impl<State, Event, Guard, tp::type_pack<Ts...>, Idx + 1> {}(
-              state, log, std::forward<Args>(args)...);
+    storage_t m_storage;
+
+    /*
+     * A machine with compact storage, an empty logger and empty metrics is
+     * no bigger than the indices of its state and guard.
+     */
+    static constexpr bool check_layout() noexcept {
+      static_assert(!__details::is_compact_v<Table> ||
+                        !std::is_empty_v<logger_t> ||
+                        !std::is_empty_v<Metrics> || queued ||
+                        sizeof(state_machine) == sizeof(storage_t),
+                    "Empty logger must not take space in the state machine");
+      return true;
+    }
+
+    using state_writers =
+        __details::type_writers<logger_t, typename Table::state_collection>;
+    using event_writers =
+        __details::type_writers<logger_t, typename Table::event_collection>;
+
+    /*
+     * Tells for every transition, if its action is called with the arguments
+     * Args..., so the batch processing calls thunks only for the transitions
+     * with actions.
+     */
+    template <typename... Args>
+    struct actions {
+      template <typename... Ts>
+      static constexpr std::array<bool, sizeof...(Ts)>
+      make(tp::type_pack<Ts...>) noexcept {
+        return {std::is_invocable_v<typename Ts::action_t, Args...>...};
       }
+
+      static constexpr auto value = make(transition_pack {});
     };
 
+    template <typename T>
+    static inline std::size_t to_event_id(const T& event) noexcept {
+      if constexpr (std::is_same_v<T, event_v>)
+        return event.index();
+      else
+        return static_cast<std::size_t>(event);
+    }
+
+    inline std::size_t cell() const noexcept {
+      return m_storage.state() * table::guard_count + m_storage.guard();
+    }
+
+    /*
+     * Performs the transition with index tr: stores the target state index
+     * and calls the action of the transition, if it has one.
+     */
+    template <typename... Args>
+    inline void transit(std::size_t tr, Args&&... args) {
+      if constexpr (!__details::is_empty_logger_v<logger_t>)
+        state_writers::value[table::targets[tr]](this->logger(),
+                                                 "Change state to ");
+      m_storage.set_state(table::targets[tr]);
+      if (actions<Args...>::value[tr]) {
+        this->logger().write("Calling an action...");
+        __details::action_thunks<Table, Args...>::value[tr](
+            std::forward<Args>(args)...);
+      }
+    }
+
+    /*
+     * Performs the transition with index tr, reporting it to the metrics.
+     */
+    template <typename... Args>
+    inline void perform(std::size_t tr, Args&&... args) {
+      if constexpr (__details::is_empty_metrics_v<Metrics>)
+        transit(tr, std::forward<Args>(args)...);
+      else
+        metrics_holder_t::get().transition(
+            tr, [&] { transit(tr, std::forward<Args>(args)...); });
+    }
+
+    inline void unhandled(std::size_t event_id) {
+      if constexpr (!__details::is_empty_metrics_v<Metrics>)
+        metrics_holder_t::get().unhandled(m_storage.state(), event_id);
+    }
+
+    /*
+     * Passes the event with the index event_id, that is in the table,
+     * without draining the internal event queue.
+     */
+    template <typename... Args>
+    inline bool handle(std::size_t event_id, Args&&... args) {
+      const std::size_t tr = __details::check_predicates<Table>(
+          table::lookup(event_id, cell()), m_storage.guard(), args...);
+      if (tr == table::no_transition) {
+        unhandled(event_id);
+        return false;
+      }
+      perform(tr, std::forward<Args>(args)...);
+      return true;
+    }
+
+    /*
+     * Passes the event and then, if this is the outermost event call, the
+     * events, that were posted meanwhile, in the order of posting, with the
+     * same arguments as lvalues.
+     */
+    template <typename... Args>
+    inline bool run(std::size_t event_id, Args&&... args) {
+      if constexpr (queued) {
+        auto& queue = queue_holder_t::queue();
+        if (queue.begin()) {
+          typename std::remove_reference_t<decltype(queue)>::run_scope scope(
+              queue);
+          const bool fired = handle(event_id, std::forward<Args>(args)...);
+          for (std::size_t id; queue.pop(id);) {
+            if constexpr (!__details::is_empty_logger_v<logger_t>)
+              event_writers::value[id](this->logger(), "Internal event: ");
+            handle(id, args...);
+          }
+          return fired;
+        }
+      }
+      return handle(event_id, std::forward<Args>(args)...);
+    }
+
   public:
-    inline state_machine()
-        : m_state(tp::at_t<0, typename Table::sources> {}), m_guard(none {}) {}
+    /**
+     * @brief Runtime index of the event Event, that is accepted by
+     * `dispatch`
+     *
+     * Events are numbered in the order of their first appearance in the
+     * transition table.
+     */
+    template <class Event>
+    static constexpr std::size_t event_id = table::template event_index<Event>;
+
+    /**
+     * @brief Fingerprint of the states and the guards of the table
+     *
+     * A hash of the state and guard types in their order in the table. A
+     * snapshot is restored only by a machine with the same fingerprint.
+     * The hash is computed from type signatures of the compiler, so it is
+     * stable across builds by the same compiler.
+     */
+    static constexpr std::uint64_t fingerprint = table::fingerprint;
+
+    inline state_machine() { static_assert(check_layout()); }
 
     /**
      * @brief Constructor that allows to initialize a logger
@@ -211,8 +1788,21 @@ namespace pure {
      * logger and pass a logger by reference; or pass it by value.
      */
     inline state_machine(logger_t custom_logger)
-        : m_state(tp::at_t<0, typename Table::sources> {}), m_guard(none {}),
-          logger(std::move(custom_logger)) {}
+        : holder_t(std::move(custom_logger)) {
+      static_assert(check_layout());
+    }
+
+    /**
+     * @brief Constructor that allows to initialize a logger and metrics
+     *
+     * Metrics may be passed by reference the same way as a logger, e.g. to
+     * be shared with a thread, that scrapes them.
+     */
+    inline state_machine(logger_t custom_logger, Metrics custom_metrics)
+        : holder_t(std::move(custom_logger)),
+          metrics_holder_t(std::forward<Metrics>(custom_metrics)) {
+      static_assert(check_layout());
+    }
 
     /**
      * @brief Pass an event to a State Machine
@@ -226,23 +1816,120 @@ namespace pure {
      *
      * If the given event causes a transition, and this transition has an
      * action, it will be called with the arguments `Args...`.
+     *
+     * The transition is found by one lookup in a dispatch table, which is
+     * built at compile time, so the cost of the call does not depend on the
+     * size of the transition table.
      */
     template <typename Event, typename... Args>
     void event(Args&&... args) {
-      logger.template write<Event>("New event: ");
-      state_v& ref_state = m_state;
-      guard_v& ref_guard = m_guard;
-      auto l = [&](const auto& arg) {
-        auto gl = [&](const auto& arg2) {
-          using event_t = Event;
-          using state_t = std::decay_t<decltype(arg)>;
-          using guard_t = std::decay_t<decltype(arg2)>;
-          event_impl<state_t, event_t, guard_t, transition_pack, 0> {}(
-              ref_state, logger, std::forward<Args>(args)...);
-        };
-        std::visit(gl, ref_guard);
-      };
-      std::visit(l, m_state);
+      this->logger().template write<Event>("New event: ");
+      if constexpr (table::template has_event<Event>)
+        run(event_id<Event>, std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Pass an event to a State Machine by its runtime index
+     *
+     * @param event_id index of the event in the event collection of the
+     * table, see `event_id`
+     * @param args arguments of the transition action
+     *
+     * @return true, if the event caused a transition
+     *
+     * Runtime counterpart of `event`: the transition is found by the event
+     * index and the current state and guard in the dispatch table, without
+     * any visitation. Indices out of the event collection are ignored.
+     */
+    template <typename... Args>
+    bool dispatch(std::size_t event_id, Args&&... args) {
+      if (event_id >= table::event_count) {
+        this->logger().write("Unknown event");
+        return false;
+      }
+      if constexpr (!__details::is_empty_logger_v<logger_t>)
+        event_writers::value[event_id](this->logger(), "New event: ");
+      return run(event_id, std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Pass an event, held by a variant of all table events
+     *
+     * @return true, if the event caused a transition
+     *
+     * Same as `dispatch(std::size_t, Args&&...)`, where the event index is
+     * the index of the alternative, held by the variant.
+     */
+    template <typename... Args>
+    inline bool dispatch(const event_v& event, Args&&... args) {
+      return dispatch(event.index(), std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Pass a sequence of runtime events to a State Machine
+     *
+     * @param first, last range of events; an event is either an index of the
+     * event (see `event_id`) or a `Table::event_v`
+     * @param args arguments of the transition actions
+     *
+     * @return the number of performed transitions
+     *
+     * Equivalent to the call of `dispatch` for every event of the range, but
+     * when the machine does not log (its logger is `empty_logger`), has no
+     * metrics (they are `empty_metrics`) and has no internal event queue,
+     * the current state is kept in a
+     * local variable through the whole batch and is written back to the
+     * machine only before an action call and at the end of the batch.
+     */
+    template <class It, typename... Args,
+              typename = typename std::iterator_traits<It>::iterator_category>
+    std::size_t process(It first, It last, Args&&... args) {
+      std::size_t fired = 0;
+      if constexpr (is_silent && !queued) {
+        std::size_t state = m_storage.state();
+        std::size_t guard = m_storage.guard();
+
+        for (; first != last; ++first) {
+          const std::size_t id = to_event_id(*first);
+          if (id >= table::event_count) continue;
+          const std::size_t tr = __details::check_predicates<Table>(
+              table::lookup(id, state * table::guard_count + guard), guard,
+              args...);
+          if (tr == table::no_transition) continue;
+          ++fired;
+          if (actions<Args&...>::value[tr]) {
+            // The action is free to call the machine, so the target state
+            // is stored before the call and the local copies are reloaded.
+            m_storage.set_state(table::targets[tr]);
+            __details::action_thunks<Table, Args&...>::value[tr](args...);
+            state = m_storage.state();
+            guard = m_storage.guard();
+          } else
+            state = table::targets[tr];
+        }
+        if (state != m_storage.state()) m_storage.set_state(state);
+      } else {
+        for (; first != last; ++first)
+          fired += dispatch(to_event_id(*first), args...);
+      }
+      return fired;
+    }
+
+    /**
+     * @brief Pass a contiguous buffer of runtime events to a State Machine
+     *
+     * @param events container or array of events, see `process(It, It,
+     * Args&&...)`
+     *
+     * @return the number of performed transitions
+     */
+    template <class Range, typename... Args,
+              typename = decltype(std::data(std::declval<const Range&>()),
+                                  std::size(std::declval<const Range&>()))>
+    inline std::size_t process(const Range& events, Args&&... args) {
+      const auto* first = std::data(events);
+      return process(first, first + std::size(events),
+                     std::forward<Args>(args)...);
     }
 
     /**
@@ -255,13 +1942,9 @@ namespace pure {
      */
     template <typename... Args>
     void action(Args&&... args) {
-      logger_t& ref_log = logger;
-      auto l = [&](const auto& arg) {
-        using state_t = std::decay_t<decltype(arg)>;
-        ref_log.template write<state_t>("Attempt to call an action for: ");
-        __details::invoke(ref_log, state_t {}, std::forward<Args>(args)...);
-      };
-      std::visit(l, m_state);
+      using state_actions = __details::state_actions<Table, logger_t, Args...>;
+      state_actions::value[m_storage.state()](this->logger(),
+                                              std::forward<Args>(args)...);
     }
 
     /**
@@ -273,10 +1956,91 @@ namespace pure {
     inline void guard() {
       if constexpr (__details::static_check_contains<Guard,
                                                      guard_collection>()) {
-        logger.template write<Guard>("New guard: ");
-        m_guard = Guard {};
+        this->logger().template write<Guard>("New guard: ");
+        m_storage.template set_guard<Guard>();
       }
     }
+
+    /**
+     * @brief Post an internal event, e.g. from a transition action
+     *
+     * @tparam Event event
+     *
+     * @return false, if the event is not in the table, or the queue is full
+     * and its overflow policy is `queue_overflow::reject`
+     *
+     * Requires the queue policy `event_queue`. An action must not pass an
+     * event to its machine by `event` or `dispatch`: the new transition
+     * would run inside of the current one. A posted event is kept in the
+     * queue inside of the machine instead, and is passed by the outermost
+     * `event` or `dispatch` call after the current event, before the call
+     * returns, so every event runs to completion before the next one. The
+     * queued events are passed with the arguments of that call as lvalues.
+     *
+     * An event, posted outside of an event call, is passed at once without
+     * arguments.
+     */
+    template <class Event>
+    inline bool post() {
+      if constexpr (table::template has_event<Event>)
+        return post(event_id<Event>);
+      else
+        return false;
+    }
+
+    /**
+     * @brief Post an internal event by its runtime index, see `post()`
+     */
+    bool post(std::size_t event_id) {
+      static_assert(queued, "Posting requires the event_queue policy");
+      if (event_id >= table::event_count) return false;
+      auto& queue = queue_holder_t::queue();
+      if (!queue.running()) {
+        run(event_id);
+        return true;
+      }
+      if (queue.push(event_id)) return true;
+      this->logger().write("Event queue is full");
+      return false;
+    }
+
+    /**
+     * @brief Metrics of the machine
+     */
+    inline const metrics_t& metrics() const noexcept {
+      return metrics_holder_t::get();
+    }
+
+    /**
+     * @brief Current state and guard of the machine with the fingerprint
+     * of its table
+     *
+     * The state and the guard are encoded by their indices, so the data of
+     * a state or a guard object is not saved.
+     */
+    inline machine_snapshot snapshot() const noexcept {
+      static_assert(table::cell_count <= UINT32_MAX,
+                    "Too many states and guards for a snapshot");
+      return {fingerprint, static_cast<std::uint32_t>(cell())};
+    }
+
+    /**
+     * @brief Set the state and the guard, saved by `snapshot`
+     *
+     * @return false, and the machine is unchanged, if the snapshot was
+     * taken from a machine with another table or is out of its cells
+     *
+     * States and guards, that are not empty types, are default constructed.
+     * No actions are called and nothing is logged.
+     */
+    inline bool restore(const machine_snapshot& snapshot) noexcept {
+      if (snapshot.fingerprint != fingerprint ||
+          snapshot.cell >= table::cell_count)
+        return false;
+      m_storage.set_state(snapshot.cell / table::guard_count);
+      m_storage.set_guard(snapshot.cell % table::guard_count);
+      return true;
+    }
   };
 
   /* guard definitions */
@@ -287,6 +2051,8 @@ namespace pure {
 
     struct logic_guard_base {};
 
+    struct predicate_guard_base {};
+
   } // namespace __details
 
   template <class Guard, class... Guards>
@@ -321,6 +2087,17 @@ namespace pure {
   template <class... Guards>
   using none_of = guard_none_of<Guards...>;
 
+  template <class Predicate>
+  struct guard_predicate : __details::predicate_guard_base {
+    /** @cond undocumented */
+    using predicate = Predicate;
+    /** @endcond */
+  };
+
+  /** @brief Typedef to guard_predicate */
+  template <class Predicate>
+  using when = guard_predicate<Predicate>;
+
   namespace __details {
 
     template <class Guard, class Target, typename AlwaysVoid>
@@ -369,12 +2146,20 @@ namespace pure {
       static constexpr bool value = true;
     };
 
+    template <class Guard, class Target>
+    struct match_impl<
+        Guard, Target,
+        std::enable_if_t<std::is_base_of_v<predicate_guard_base, Target>>> {
+      static constexpr bool value = true;
+    };
+
     /*
      * match checks if the guard Guard matches with guard Target.
      * Provides constant member, which is true in the following cases:
      * if Guard == Target
      * if Target == any_of and Guard is appeared in its guard pack
      * if Target == none_of and Guard is not appeared in its guard pack
+     * if Target is a predicate, which is checked at the time of the event
      *
      * Otherwise the value of member is false.
      */
@@ -386,6 +2171,12 @@ namespace pure {
       static constexpr bool value = std::is_base_of_v<logic_guard_base, Guard>;
     };
 
+    template <class Guard>
+    struct is_predicate_guard {
+      static constexpr bool value =
+          std::is_base_of_v<predicate_guard_base, Guard>;
+    };
+
     template <class Guard, typename AlwaysVoid>
     struct unpack_guard_impl {
       using type = tp::just_type<Guard>;
@@ -397,22 +2188,19 @@ namespace pure {
       using type = typename Guard::pack;
     };
 
+    /* Predicates are not kept by the machine, so they are not guards */
     template <class Guard>
-    struct unpack_guard : unpack_guard_impl<Guard, void> {};
-
-    template <class GuardPack>
-    struct unpack_guards {};
-
-    template <typename T, typename... Ts>
-    struct unpack_guards<tp::type_pack<T, Ts...>> {
-      using pack = typename unpack_guard<T>::type;
-      using next = typename unpack_guards<tp::type_pack<Ts...>>::type;
-      using type = tp::concatenate_t<pack, next>;
+    struct unpack_guard_impl<
+        Guard, std::enable_if_t<is_predicate_guard<Guard>::value>> {
+      using type = tp::empty_pack;
     };
 
-    template <>
-    struct unpack_guards<tp::empty_pack> {
-      using type = tp::empty_pack;
+    template <class Guard>
+    struct unpack_guard : unpack_guard_impl<Guard, void> {};
+
+    template <typename... Gs>
+    struct unpack_guards<tp::type_pack<Gs...>> {
+      using type = join_t<typename unpack_guard<Gs>::type...>;
     };
 
   } // namespace __details
@@ -0,0 +1,406 @@
+/**
+ * @file journal.hpp
+ *
+ * File that contains an append-only binary journal of events, passed to
+ * arrays of State Machines, and its replay.
+ */
+#ifndef PUREFSM_JOURNAL_HPP
+#define PUREFSM_JOURNAL_HPP
+
+#include "fsm.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pure {
+
+  namespace __details {
+
+    /*
+     * A journal starts with a header of 32 bytes, records follow it in the
+     * byte order of the machine.
+     */
+    struct journal_header {
+      std::uint64_t magic;
+      std::uint64_t fingerprint;
+      std::uint64_t record_size;
+      std::uint64_t reserved;
+    };
+
+    inline constexpr std::uint64_t journal_magic =
+        0x316a73664d4650ull; // "PFMfsj1"
+
+    template <class Payload>
+    struct journal_record {
+      std::uint32_t machine;
+      std::uint32_t event;
+      Payload payload;
+    };
+
+    template <>
+    struct journal_record<none> {
+      std::uint32_t machine;
+      std::uint32_t event;
+    };
+
+    template <class Table, class Payload>
+    constexpr journal_header make_journal_header() noexcept {
+      return {journal_magic, compiled_table<Table>::fingerprint,
+              sizeof(journal_record<Payload>), 0};
+    }
+
+    template <class Table, class Payload>
+    inline bool check_journal_header(const journal_header& header) noexcept {
+      constexpr journal_header expected = make_journal_header<Table, Payload>();
+      return header.magic == expected.magic &&
+             header.fingerprint == expected.fingerprint &&
+             header.record_size == expected.record_size;
+    }
+
+  } // namespace __details
+
+  /**
+   * @brief Append-only journal of events, passed to an array of State
+   * Machines
+   *
+   * @tparam Table transition_table
+   * @tparam Payload trivially copyable value, that is written with an event
+   * and is passed to the transition action on replay; `none` if events
+   * carry no value
+   * @tparam Group number of records, that are written to the file at once
+   *
+   * A record holds the index of a machine, the runtime index of an event
+   * (see `state_machine::event_id`) and the payload, 8 bytes without a
+   * payload. Records are collected in memory and are committed as a group:
+   * by one `pwrite` and one `fdatasync`, when the group is full, by `commit`
+   * and by the destructor. Only committed records survive a crash of the
+   * system.
+   *
+   * The file starts with a header, that holds the fingerprint of the table
+   * and the size of a record, so a journal is replayed only into machines
+   * of the same table. Opening an existing journal appends to it; a torn
+   * record at its end, left by a crash, is cut off.
+   *
+   * A journal is written by one thread at a time.
+   */
+  template <class Table, class Payload = none, std::size_t Group = 1024>
+  class event_journal {
+    static_assert(std::is_trivially_copyable_v<Payload>,
+                  "Journal payload must be trivially copyable");
+    static_assert(Group > 0, "Group must hold at least one record");
+
+  public:
+    /** @brief Record of the journal */
+    using record_type = __details::journal_record<Payload>;
+
+    /**
+     * @brief Runtime index of the event Event
+     */
+    template <class Event>
+    static constexpr std::size_t event_id =
+        __details::compiled_table<Table>::template event_index<Event>;
+
+  private:
+    using table = __details::compiled_table<Table>;
+    using header_t = __details::journal_header;
+
+    int m_fd = -1;
+    // End of the committed records, where the next group is written
+    off_t m_end = 0;
+    std::vector<record_type> m_group;
+
+    bool open(const char* path) noexcept {
+      m_fd = ::open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+      if (m_fd < 0) return false;
+
+      struct stat st {};
+      if (fstat(m_fd, &st) != 0) return false;
+      const auto size = static_cast<std::size_t>(st.st_size);
+
+      if (size == 0) {
+        constexpr header_t header =
+            __details::make_journal_header<Table, Payload>();
+        return write_all(&header, sizeof(header)) && fdatasync(m_fd) == 0;
+      }
+
+      header_t header {};
+      if (size < sizeof(header) ||
+          pread(m_fd, &header, sizeof(header), 0) != sizeof(header) ||
+          !__details::check_journal_header<Table, Payload>(header))
+        return false;
+
+      const std::size_t tail = (size - sizeof(header)) % sizeof(record_type);
+      m_end = static_cast<off_t>(size - tail);
+      return !tail || ftruncate(m_fd, m_end) == 0;
+    }
+
+    /*
+     * Writes the bytes at the end of the committed records and moves the
+     * end past them.
+     */
+    bool write_all(const void* data, std::size_t bytes) noexcept {
+      const char* first = static_cast<const char*>(data);
+      while (bytes) {
+        const ssize_t written = ::pwrite(m_fd, first, bytes, m_end);
+        if (written < 0 && errno == EINTR) continue;
+        if (written < 0) return false;
+        first += written;
+        m_end += written;
+        bytes -= static_cast<std::size_t>(written);
+      }
+      return true;
+    }
+
+  public:
+    /**
+     * @brief Opens the journal at path for appending, creating it if
+     * missing
+     *
+     * A file, that is not a journal of this table and payload, is not
+     * opened and is left untouched, see `is_open`.
+     */
+    explicit event_journal(const char* path) {
+      m_group.reserve(Group);
+      if (!open(path) && m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+      }
+    }
+
+    event_journal(const event_journal&) = delete;
+    event_journal& operator=(const event_journal&) = delete;
+
+    /**
+     * @brief Commits the pending records and closes the file
+     */
+    ~event_journal() {
+      if (m_fd < 0) return;
+      commit();
+      ::close(m_fd);
+    }
+
+    /**
+     * @brief Tells, if the file is open
+     */
+    inline bool is_open() const noexcept { return m_fd >= 0; }
+
+    /**
+     * @brief Number of records, that are appended, but not committed yet
+     */
+    inline std::size_t pending() const noexcept { return m_group.size(); }
+
+    /**
+     * @brief Append the event Event, passed to the machine with the index
+     * machine
+     *
+     * @return false, if the file is not open, or if the group was full and
+     * could not be committed
+     */
+    template <class Event, typename... Args>
+    inline bool append(std::uint32_t machine, Args&&... payload) {
+      static_assert(table::template has_event<Event>,
+                    "Event is not in the table");
+      return append(machine, event_id<Event>, std::forward<Args>(payload)...);
+    }
+
+    /**
+     * @brief Append an event by its runtime index
+     *
+     * @return false, if the file is not open, or if the group was full and
+     * could not be committed
+     */
+    template <typename... Args>
+    bool append(std::uint32_t machine, std::size_t event_id,
+                Args&&... payload) {
+      if (m_fd < 0) return false;
+      // The record is zeroed and filled in place, so its padding is written
+      // to the file as zeros, not as bytes of the stack
+      record_type& rec = m_group.emplace_back();
+      std::memset(&rec, 0, sizeof(rec));
+      rec.machine = machine;
+      rec.event = static_cast<std::uint32_t>(event_id);
+      if constexpr (std::is_same_v<Payload, none>)
+        static_assert(sizeof...(Args) == 0, "Journal has no payload");
+      else
+        ::new (&rec.payload) Payload {std::forward<Args>(payload)...};
+      return m_group.size() < Group || commit();
+    }
+
+    /**
+     * @brief Write the pending records and wait until they reach the disk
+     *
+     * @return false, if the file is not open or the write failed; the
+     * records stay pending then
+     */
+    bool commit() noexcept {
+      if (m_fd < 0) return false;
+      if (m_group.empty()) return true;
+      const off_t end = m_end;
+      if (!write_all(m_group.data(), m_group.size() * sizeof(record_type)) ||
+          fdatasync(m_fd) != 0) {
+        // The written part of the group is cut off, so the retry does not
+        // leave a torn or a repeated record in the middle of the journal;
+        // if the cut fails, the retry overwrites that part.
+        m_end = end;
+        (void)ftruncate(m_fd, end);
+        return false;
+      }
+      m_group.clear();
+      return true;
+    }
+  };
+
+  /**
+   * @brief Read-only view of a journal, written by `event_journal`, that
+   * replays it into an array of State Machines
+   *
+   * The file is mapped into memory and is read sequentially, so the replay
+   * costs little more than the dispatch of every event. A torn record at
+   * the end of the file is ignored.
+   */
+  template <class Table, class Payload = none>
+  class journal_reader {
+  public:
+    /** @brief Record of the journal */
+    using record_type = __details::journal_record<Payload>;
+
+  private:
+    using header_t = __details::journal_header;
+
+    void* m_map = nullptr;
+    std::size_t m_bytes = 0;
+    const record_type* m_records = nullptr;
+    std::size_t m_size = 0;
+
+    template <class Machine>
+    static inline bool apply(Machine& machine, const record_type& rec) {
+      if constexpr (std::is_same_v<Payload, none>)
+        return machine.dispatch(rec.event);
+      else {
+        Payload payload = rec.payload;
+        return machine.dispatch(rec.event, payload);
+      }
+    }
+
+    /*
+     * Replays the records of the machines in [first, last); returns the
+     * number of transitions.
+     */
+    template <class Machine>
+    std::size_t replay_range(Machine* machines, std::size_t first,
+                             std::size_t last) const {
+      std::size_t transitions = 0;
+      for (std::size_t idx = 0; idx < m_size; ++idx) {
+        const record_type& rec = m_records[idx];
+        if (rec.machine < first || rec.machine >= last) continue;
+        transitions += apply(machines[rec.machine], rec);
+      }
+      return transitions;
+    }
+
+  public:
+    /**
+     * @brief Maps the journal at path
+     *
+     * A missing file or a journal of another table or payload is not
+     * opened, see `is_open`.
+     */
+    explicit journal_reader(const char* path) noexcept {
+      const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+      if (fd < 0) return;
+      struct stat st {};
+      if (fstat(fd, &st) == 0 &&
+          static_cast<std::size_t>(st.st_size) >= sizeof(header_t)) {
+        m_bytes = static_cast<std::size_t>(st.st_size);
+        void* map = mmap(nullptr, m_bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) m_map = map;
+      }
+      ::close(fd);
+      if (!m_map) return;
+
+      if (!__details::check_journal_header<Table, Payload>(
+              *static_cast<const header_t*>(m_map))) {
+        munmap(m_map, m_bytes);
+        m_map = nullptr;
+        return;
+      }
+      madvise(m_map, m_bytes, MADV_SEQUENTIAL);
+      m_records = reinterpret_cast<const record_type*>(
+          static_cast<const char*>(m_map) + sizeof(header_t));
+      m_size = (m_bytes - sizeof(header_t)) / sizeof(record_type);
+    }
+
+    journal_reader(const journal_reader&) = delete;
+    journal_reader& operator=(const journal_reader&) = delete;
+
+    ~journal_reader() {
+      if (m_map) munmap(m_map, m_bytes);
+    }
+
+    /**
+     * @brief Tells, if the journal is mapped
+     */
+    inline bool is_open() const noexcept { return m_map != nullptr; }
+
+    /**
+     * @brief Number of whole records in the journal
+     */
+    inline std::size_t size() const noexcept { return m_size; }
+
+    /**
+     * @brief Record with the index idx, in the order of appending
+     */
+    inline const record_type& operator[](std::size_t idx) const noexcept {
+      return m_records[idx];
+    }
+
+    /**
+     * @brief Pass every event of the journal to its machine
+     *
+     * @param machines array of count machines, `state_machine` or any
+     * other with the same `dispatch`
+     * @param threads number of threads; every thread drives a contiguous
+     * range of the machines and reads the whole journal, so events of one
+     * machine keep their order and threads never share a machine
+     *
+     * @return the number of events, that caused a transition
+     *
+     * Records of machines out of the array are skipped.
+     */
+    template <class Machine>
+    std::size_t replay(Machine* machines, std::size_t count,
+                       std::size_t threads = 1) const {
+      if (threads > count) threads = count;
+      if (threads <= 1) return replay_range(machines, 0, count);
+
+      std::atomic<std::size_t> transitions {0};
+      std::vector<std::thread> workers;
+      workers.reserve(threads);
+      for (std::size_t shard = 0; shard < threads; ++shard)
+        workers.emplace_back([&, shard] {
+          transitions.fetch_add(
+              replay_range(machines, count * shard / threads,
+                           count * (shard + 1) / threads),
+              std::memory_order_relaxed);
+        });
+      for (auto& worker : workers) worker.join();
+      return transitions.load(std::memory_order_relaxed);
+    }
+  };
+
+} // namespace pure
+
+#endif
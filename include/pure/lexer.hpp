@@ -0,0 +1,412 @@
+/**
+ * @file lexer.hpp
+ *
+ * File that contains byte classes, that are events of the bytes of an input
+ * stream, and a State Machine, that runs over whole buffers of bytes.
+ */
+#ifndef PUREFSM_LEXER_HPP
+#define PUREFSM_LEXER_HPP
+
+#include "fsm.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+#if defined(__SSSE3__) || defined(__AVX2__)
+  #include <immintrin.h>
+#endif
+
+namespace pure {
+
+  /**
+   * @brief Event of any byte from First to Last inclusive
+   *
+   * A byte class is any type with the static member function
+   * `static constexpr bool contains(unsigned char)`.
+   */
+  template <unsigned char First, unsigned char Last>
+  struct byte_range {
+    static_assert(First <= Last, "Empty byte range");
+
+    static constexpr bool contains(unsigned char byte) noexcept {
+      return First <= byte && byte <= Last;
+    }
+  };
+
+  /**
+   * @brief Event of any of the bytes Chars
+   *
+   * ```cpp
+   * tr<Number, pure::byte_set<'e', 'E'>, Exponent, none, none>
+   * ```
+   */
+  template <char... Chars>
+  struct byte_set {
+    static constexpr bool contains(unsigned char byte) noexcept {
+      return (... || (byte == static_cast<unsigned char>(Chars)));
+    }
+  };
+
+  /**
+   * @brief Event of every byte
+   */
+  using any_byte = byte_range<0, 255>;
+
+  namespace __details {
+
+    template <class Event, typename AlwaysVoid = void>
+    struct is_byte_class : std::false_type {};
+
+    template <class Event>
+    struct is_byte_class<
+        Event, std::void_t<decltype(Event::contains(
+                   std::declval<unsigned char>()))>> : std::true_type {};
+
+    template <class Event>
+    constexpr std::array<bool, 256> byte_members() noexcept {
+      std::array<bool, 256> members {};
+      if constexpr (is_byte_class<Event>::value)
+        for (std::size_t byte = 0; byte < 256; ++byte)
+          members[byte] = Event::contains(static_cast<unsigned char>(byte));
+      return members;
+    }
+
+    template <class Events>
+    struct byte_classes;
+
+    template <typename... Es>
+    struct byte_classes<tp::type_pack<Es...>> {
+      static constexpr std::array<std::array<bool, 256>, sizeof...(Es)>
+          value = {byte_members<Es>()...};
+    };
+
+    /*
+     * byte_table maps every cell (state * G + guard) and every byte to the
+     * first transition of the table, whose source matches the cell and
+     * whose event is a byte class, that contains the byte. Transitions,
+     * that keep the state and call no action or predicate, are idle: they
+     * are mapped to no_transition, so runs of such bytes are skipped.
+     */
+    template <class Table>
+    struct byte_table {
+      using table = compiled_table<Table>;
+      using index_t = typename table::index_t;
+
+      static constexpr std::size_t cell_count = table::cell_count;
+
+    private:
+      template <typename... Ts>
+      static constexpr std::array<bool, sizeof...(Ts)>
+      make_actions(tp::type_pack<Ts...>) noexcept {
+        return {!std::is_same_v<typename Ts::action_t, none>...};
+      }
+
+    public:
+      /** Tells for every transition, if it has an action */
+      static constexpr std::array<bool, table::transition_count> actions =
+          make_actions(typename Table::transitions {});
+
+    private:
+      static constexpr bool idle(std::size_t tr) noexcept {
+        return !table::predicates[tr] && !actions[tr] &&
+               table::sources[tr] == table::targets[tr];
+      }
+
+      static constexpr std::array<index_t, cell_count * 256>
+      make_rows() noexcept {
+        constexpr auto& classes =
+            byte_classes<typename Table::event_collection>::value;
+        std::array<index_t, cell_count * 256> rows {};
+        for (std::size_t cell = 0; cell < cell_count; ++cell)
+          for (std::size_t byte = 0; byte < 256; ++byte) {
+            std::size_t first = table::no_transition;
+            for (std::size_t event = 0; event < table::event_count; ++event)
+              if (classes[event][byte]) {
+                const std::size_t tr = table::lookup(event, cell);
+                first = tr < first ? tr : first;
+              }
+            if (first != table::no_transition && idle(first))
+              first = table::no_transition;
+            rows[cell * 256 + byte] = static_cast<index_t>(first);
+          }
+        return rows;
+      }
+
+    public:
+      /** The row of a cell starts at `cell * 256` */
+      static constexpr std::array<index_t, cell_count * 256> rows =
+          make_rows();
+
+      /*
+       * Masks of the bytes, that stop a skip in a cell: the bit
+       * (byte >> 4) & 7 of low[byte & 15], if byte < 128, and of
+       * high[byte & 15] otherwise.
+       */
+      struct stop_masks {
+        std::array<std::uint8_t, 16> low {};
+        std::array<std::uint8_t, 16> high {};
+      };
+
+    private:
+      static constexpr std::array<stop_masks, cell_count>
+      make_stops() noexcept {
+        std::array<stop_masks, cell_count> stops {};
+        for (std::size_t cell = 0; cell < cell_count; ++cell)
+          for (std::size_t byte = 0; byte < 256; ++byte)
+            if (rows[cell * 256 + byte] != table::no_transition) {
+              auto& mask = byte < 128 ? stops[cell].low : stops[cell].high;
+              mask[byte & 15] |=
+                  static_cast<std::uint8_t>(1u << (byte >> 4 & 7));
+            }
+        return stops;
+      }
+
+    public:
+      static constexpr std::array<stop_masks, cell_count> stops =
+          make_stops();
+    };
+
+    /*
+     * Calls the action of a transition with the position of the byte, that
+     * caused it, and the arguments, or only with the arguments.
+     */
+    template <class Action, typename... Args>
+    void call_byte_action(const char* at, Args&... args) {
+      if constexpr (std::is_invocable_v<Action, const char*, Args&...>)
+        Action {}(at, args...);
+      else if constexpr (std::is_invocable_v<Action, Args&...>)
+        Action {}(args...);
+    }
+
+    template <class Table, typename... Args>
+    struct byte_action_thunks {
+      template <typename... Ts>
+      static constexpr std::array<void (*)(const char*, Args&...),
+                                  sizeof...(Ts)>
+      make(tp::type_pack<Ts...>) noexcept {
+        return {&call_byte_action<typename Ts::action_t, Args...>...};
+      }
+
+      static constexpr auto value = make(typename Table::transitions {});
+    };
+
+#if defined(__AVX2__)
+    /*
+     * Returns the first byte from at, that is not skipped in the cell, or
+     * the position, after which less than 32 bytes are left. Truffle: the
+     * byte picks a mask by its low nibble and a bit of it by its high one.
+     */
+    template <class Stops>
+    inline const char* skip(const Stops& stops, const char* at,
+                            const char* end) noexcept {
+      const __m256i low = _mm256_broadcastsi128_si256(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(stops.low.data())));
+      const __m256i high = _mm256_broadcastsi128_si256(_mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(stops.high.data())));
+      const __m256i bits = _mm256_setr_epi8(
+          1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 4, 8, 16,
+          32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0);
+      const __m256i flip = _mm256_set1_epi8(-128);
+      const __m256i seven = _mm256_set1_epi8(7);
+
+      for (; end - at >= 32; at += 32) {
+        const __m256i bytes =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(at));
+        const __m256i masks = _mm256_or_si256(
+            _mm256_shuffle_epi8(low, bytes),
+            _mm256_shuffle_epi8(high, _mm256_xor_si256(bytes, flip)));
+        const __m256i bit = _mm256_shuffle_epi8(
+            bits, _mm256_and_si256(_mm256_srli_epi16(bytes, 4), seven));
+        const __m256i pass = _mm256_cmpeq_epi8(_mm256_and_si256(masks, bit),
+                                               _mm256_setzero_si256());
+        const auto stop =
+            ~static_cast<std::uint32_t>(_mm256_movemask_epi8(pass));
+        if (stop) return at + __builtin_ctz(stop);
+      }
+      return at;
+    }
+#elif defined(__SSSE3__)
+    /*
+     * Returns the first byte from at, that is not skipped in the cell, or
+     * the position, after which less than 16 bytes are left. Truffle: the
+     * byte picks a mask by its low nibble and a bit of it by its high one.
+     */
+    template <class Stops>
+    inline const char* skip(const Stops& stops, const char* at,
+                            const char* end) noexcept {
+      const __m128i low =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(stops.low.data()));
+      const __m128i high =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(stops.high.data()));
+      const __m128i bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 0, 0,
+                                         0, 0, 0, 0, 0, 0);
+      const __m128i flip = _mm_set1_epi8(-128);
+      const __m128i seven = _mm_set1_epi8(7);
+
+      for (; end - at >= 16; at += 16) {
+        const __m128i bytes =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(at));
+        const __m128i masks =
+            _mm_or_si128(_mm_shuffle_epi8(low, bytes),
+                         _mm_shuffle_epi8(high, _mm_xor_si128(bytes, flip)));
+        const __m128i bit = _mm_shuffle_epi8(
+            bits, _mm_and_si128(_mm_srli_epi16(bytes, 4), seven));
+        const __m128i pass =
+            _mm_cmpeq_epi8(_mm_and_si128(masks, bit), _mm_setzero_si128());
+        const auto stop =
+            ~static_cast<std::uint32_t>(_mm_movemask_epi8(pass)) & 0xFFFFu;
+        if (stop) return at + __builtin_ctz(stop);
+      }
+      return at;
+    }
+#endif
+
+  } // namespace __details
+
+  /**
+   * @brief State Machine, that runs over buffers of bytes
+   *
+   * @tparam Table transition table, whose events are byte classes
+   * (`byte_range`, `byte_set`, `any_byte` or user types with
+   * `static constexpr bool contains(unsigned char)`) and, optionally, other
+   * events, e.g. the end of the input
+   *
+   * Every byte is an event: the first transition of the table from the
+   * current state, whose byte class contains the byte and whose guard
+   * matches, is performed. The transitions are compiled into a table of 256
+   * entries per state and guard, so a byte costs one indexed load.
+   *
+   * Predicates of the transitions by one byte class are tried in the order
+   * of the table, as for other events.
+   *
+   * A transition, that keeps the state and has neither an action nor a
+   * predicate, is idle: it is not performed at all, like a byte without a
+   * transition. With SSSE3 or AVX2 runs of such bytes are skipped 16 or 32
+   * bytes at once.
+   *
+   * An action is called with the position of the byte (`const char*`) and
+   * the arguments of `feed`, if it accepts them, or only with the
+   * arguments.
+   *
+   * ```cpp
+   * using table = pure::transition_table<
+   *     pure::tr<Space, pure::byte_range<'0', '9'>, Number, Begin, none>,
+   *     pure::tr<Number, pure::byte_set<' ', '\n'>, Space, End, none>>;
+   *
+   * pure::byte_lexer<table> lexer;
+   * lexer.feed(buffer, tokens);
+   * ```
+   */
+  template <class Table>
+  class byte_lexer {
+  private:
+    using table = __details::compiled_table<Table>;
+    using bytes = __details::byte_table<Table>;
+    using cell_t = __details::least_uint_t<table::cell_count - 1>;
+
+    cell_t m_cell = static_cast<cell_t>(table::template guard_index<none>);
+
+    template <typename... Args>
+    inline void perform(std::size_t tr, std::size_t guard, const char* at,
+                        Args&... args) {
+      m_cell = static_cast<cell_t>(table::targets[tr] * table::guard_count +
+                                   guard);
+      if (bytes::actions[tr])
+        __details::byte_action_thunks<Table, Args...>::value[tr](at,
+                                                                  args...);
+    }
+
+  public:
+    /**
+     * @brief Pass every byte of the input as an event
+     *
+     * @return the number of performed transitions, idle ones excluded
+     */
+    template <typename... Args>
+    inline std::size_t feed(std::string_view input, Args&&... args) {
+      const char* at = input.data();
+      const char* const end = at + input.size();
+      const std::size_t guard = m_cell % table::guard_count;
+      std::size_t cell = m_cell;
+      const auto* row = bytes::rows.data() + cell * 256;
+      std::size_t count = 0;
+
+      for (; at != end; ++at) {
+        std::size_t tr = row[static_cast<unsigned char>(*at)];
+        if (tr == table::no_transition) {
+#if defined(__SSSE3__) || defined(__AVX2__)
+          at = __details::skip(bytes::stops[cell], at + 1, end) - 1;
+#endif
+          continue;
+        }
+        if constexpr (table::has_predicates) {
+          tr = __details::check_predicates<Table>(tr, guard, args...);
+          if (tr == table::no_transition) continue;
+        }
+        perform(tr, guard, at, args...);
+        cell = m_cell;
+        row = bytes::rows.data() + cell * 256;
+        ++count;
+      }
+      return count;
+    }
+
+    /**
+     * @brief Pass an event, e.g. the end of the input
+     *
+     * Actions are called with a null position.
+     *
+     * @return true, if the event caused a transition
+     */
+    template <class Event, typename... Args>
+    inline bool event(Args&&... args) {
+      if constexpr (!table::template has_event<Event>)
+        return false;
+      else {
+        const std::size_t guard = m_cell % table::guard_count;
+        const std::size_t tr = __details::check_predicates<Table>(
+            table::lookup(table::template event_index<Event>, m_cell), guard,
+            args...);
+        if (tr == table::no_transition) return false;
+        perform(tr, guard, nullptr, args...);
+        return true;
+      }
+    }
+
+    /**
+     * @brief Change the current guard
+     */
+    template <class Guard>
+    inline void guard() noexcept {
+      if constexpr (__details::static_check_contains<
+                        Guard, typename Table::guard_collection>())
+        m_cell = static_cast<cell_t>(m_cell - m_cell % table::guard_count +
+                                     table::template guard_index<Guard>);
+    }
+
+    /**
+     * @brief Index of the current state in the state collection
+     */
+    inline std::size_t state() const noexcept {
+      return m_cell / table::guard_count;
+    }
+
+    /**
+     * @brief Checks, if the current state is State
+     */
+    template <class State>
+    inline bool is_in() const noexcept {
+      if constexpr (__details::static_check_contains<
+                        State, typename Table::state_collection>())
+        return state() == table::template state_index<State>;
+      else
+        return false;
+    }
+  };
+
+} // namespace pure
+
+#endif
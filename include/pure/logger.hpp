@@ -6,7 +6,13 @@
 #ifndef PUREFSM_LOGGER_HPP
 #define PUREFSM_LOGGER_HPP
 
+#include "fsm.hpp"
+
+#include <array>
+#include <cstddef>
 #include <ostream>
+#include <string_view>
+#include <utility>
 
 namespace pure {
 
@@ -17,59 +23,175 @@ namespace pure {
    */
   namespace logger {
 
-    /**
-     * @fn type_name
-     *
-     * @tparam T type
-     *
-     * @brief Compile-time reflection
-     *
-     * Returns a string that is a name of a type T. Compiler dependent.
-     * If the compiler does not supports compile-time function signature
-     * reflection, the function will be returning an empty string.
-     *
-     * See @ref fsm_logger
-     */
+    namespace __details {
 
 #if defined(__GNUC__) || defined(__MINGW32__) || defined(__clang__) ||         \
     defined(__INTEL_COMPILER) || (defined(__ICC) && (__ICC >= 600)) ||         \
     (defined(__DMC__) && __DMC__ >= 0x810)
 
-    template <typename T>
-    std::string type_name() {
-      using size_type = typename std::string::size_type;
-      char const* str = __PRETTY_FUNCTION__;
-      while (*str != '=') ++str;
-      str += 2;
-      size_type size = 0;
-      while (str[size] != ';' && str[size] != ']') ++size;
-      return std::string(str, size);
-    }
+      template <typename T>
+      constexpr std::string_view signature() noexcept {
+        return __PRETTY_FUNCTION__;
+      }
+
+      /*
+       * The signature is "... signature() [with T = Name; ...]" or
+       * "... signature() [T = Name]".
+       */
+      constexpr std::string_view extract(std::string_view sig) noexcept {
+        const auto first = sig.find("T = ") + 4;
+        const auto last = sig.find_first_of(";]", first);
+        return sig.substr(first, last - first);
+      }
 
 #elif defined(__MSC_VER) || defined(__FUNCSIG__)
 
-    template <typename T>
-    std::string type_name() {
-      using size_type = typename std::string::size_type;
-      const std::string s = __FUNCSIG__;
-      const std::string fname = "type_name<";
-      const std::string rest = ">(void)";
-      size_type pos = s.find(fname) + fname.size();
-      size_type count = s.find(rest) - pos;
-      return std::string(s, pos, count);
-    }
+      template <typename T>
+      constexpr std::string_view signature() noexcept {
+        return __FUNCSIG__;
+      }
+
+      /* The signature is "... signature<Name>(void)" */
+      constexpr std::string_view extract(std::string_view sig) noexcept {
+        const auto first = sig.find("signature<") + 10;
+        const auto last = sig.rfind(">(void)");
+        return sig.substr(first, last - first);
+      }
 
 #else
 
   #warning                                                                     \
       "Your compiler does not support the reflection required by the logger"
 
+      template <typename T>
+      constexpr std::string_view signature() noexcept {
+        return {};
+      }
+
+      constexpr std::string_view extract(std::string_view) noexcept {
+        return {};
+      }
+
+#endif
+
+      /*
+       * The name is copied out of the function signature into a static
+       * array, so it does not depend on the lifetime of the signature.
+       */
+      template <typename T>
+      struct type_name_storage {
+        static constexpr std::string_view view = extract(signature<T>());
+
+        template <std::size_t... Is>
+        static constexpr std::array<char, sizeof...(Is) + 1>
+        copy(std::index_sequence<Is...>) noexcept {
+          return {view[Is]..., '\0'};
+        }
+
+        static constexpr auto value =
+            copy(std::make_index_sequence<view.size()> {});
+      };
+
+    } // namespace __details
+
+    /**
+     * @brief Compile-time reflection
+     *
+     * @tparam T type
+     *
+     * Returns a name of a type T. The name is computed at compile time and
+     * refers to a static null-terminated string, so the call costs nothing
+     * at run time. Compiler dependent: if the compiler does not support
+     * compile-time function signature reflection, the name is empty.
+     *
+     * See @ref fsm_logger
+     */
     template <typename T>
-    std::string type_name() {
-      return {};
+    constexpr std::string_view type_name() noexcept {
+      using storage = __details::type_name_storage<T>;
+      return {storage::value.data(), storage::view.size()};
     }
 
-#endif
+    /**
+     * @brief Dense numeric identifiers of the types of a transition table
+     *
+     * @tparam Table transition_table
+     *
+     * States, events and guards of the table are numbered one after
+     * another: states by their position in the state collection, then
+     * events, then guards. So a logger or a tracer may record an integer
+     * and look its name up later in `names`.
+     */
+    template <class Table>
+    struct type_ids {
+    private:
+      using states = typename Table::state_collection;
+      using events = typename Table::event_collection;
+      using guards = typename Table::guard_collection;
+
+      template <typename... Ts>
+      static constexpr std::array<std::string_view, sizeof...(Ts)>
+      make_names(tp::type_pack<Ts...>) noexcept {
+        return {type_name<Ts>()...};
+      }
+
+      template <std::size_t N, std::size_t M, std::size_t K>
+      static constexpr std::array<std::string_view, N + M + K>
+      join(const std::array<std::string_view, N>& first,
+           const std::array<std::string_view, M>& second,
+           const std::array<std::string_view, K>& third) noexcept {
+        std::array<std::string_view, N + M + K> result {};
+        for (std::size_t idx = 0; idx < N; ++idx) result[idx] = first[idx];
+        for (std::size_t idx = 0; idx < M; ++idx)
+          result[N + idx] = second[idx];
+        for (std::size_t idx = 0; idx < K; ++idx)
+          result[N + M + idx] = third[idx];
+        return result;
+      }
+
+      /*
+       * Index of T in the collection; index_of returns the size of the
+       * collection for a missing type, which is the first id of the next
+       * category.
+       */
+      template <class T, class Pack>
+      static constexpr std::size_t index_in() noexcept {
+        static_assert(tp::contains<T, Pack>::value,
+                      "Type is not in this collection of the table");
+        return pure::__details::index_of<T>(Pack {});
+      }
+
+    public:
+      /** @brief Number of identifiers */
+      static constexpr std::size_t size =
+          states::size() + events::size() + guards::size();
+
+      /** @brief Identifier of the state State */
+      template <class State>
+      static constexpr std::size_t state_id = index_in<State, states>();
+
+      /** @brief Identifier of the event Event */
+      template <class Event>
+      static constexpr std::size_t event_id =
+          states::size() + index_in<Event, events>();
+
+      /** @brief Identifier of the guard Guard */
+      template <class Guard>
+      static constexpr std::size_t guard_id =
+          states::size() + events::size() + index_in<Guard, guards>();
+
+      /** @brief Names of the types, indexed by their identifiers */
+      static constexpr std::array<std::string_view, size> names =
+          join(make_names(states {}), make_names(events {}),
+               make_names(guards {}));
+
+      /**
+       * @brief Name of the type with the identifier, or an empty string
+       */
+      static constexpr std::string_view name(std::size_t id) noexcept {
+        return id < size ? names[id] : std::string_view {};
+      }
+    };
 
   } // namespace logger
 
@@ -0,0 +1,377 @@
+/**
+ * @file mapped_store.hpp
+ *
+ * File that contains a persistent store of State Machines, whose states
+ * are kept in a memory-mapped file.
+ */
+#ifndef PUREFSM_MAPPED_STORE_HPP
+#define PUREFSM_MAPPED_STORE_HPP
+
+#include "fsm.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pure {
+
+  /**
+   * @brief Sync policy of a mapped_machine_store: changed pages are written
+   * to the file by the kernel, whenever it decides to
+   *
+   * States survive a crash or a restart of the process, but not a crash of
+   * the system. `flush` still writes the changed pages synchronously.
+   */
+  struct no_sync {
+    /** @cond undocumented */
+    static constexpr std::size_t batch = 0;
+
+    static inline void sync(int, void* first, std::size_t bytes) noexcept {
+      msync(first, bytes, MS_SYNC);
+    }
+    /** @endcond */
+  };
+
+  /**
+   * @brief Sync policy of a mapped_machine_store: the changed pages are
+   * written synchronously by `msync` after every Batch transitions
+   */
+  template <std::size_t Batch>
+  struct msync_batch {
+    static_assert(Batch > 0, "Batch must hold at least one transition");
+
+    /** @cond undocumented */
+    static constexpr std::size_t batch = Batch;
+
+    static inline void sync(int, void* first, std::size_t bytes) noexcept {
+      msync(first, bytes, MS_SYNC);
+    }
+    /** @endcond */
+  };
+
+  /**
+   * @brief Sync policy of a mapped_machine_store: the file data is written
+   * synchronously by `fdatasync` after every Batch transitions
+   *
+   * Writes all dirty pages of the file at once, which is cheaper than
+   * `msync` of scattered ranges on most file systems.
+   */
+  template <std::size_t Batch>
+  struct fdatasync_batch {
+    static_assert(Batch > 0, "Batch must hold at least one transition");
+
+    /** @cond undocumented */
+    static constexpr std::size_t batch = Batch;
+
+    static inline void sync(int fd, void*, std::size_t) noexcept {
+      fdatasync(fd);
+    }
+    /** @endcond */
+  };
+
+  /**
+   * @brief Persistent array of State Machines, kept in a memory-mapped file
+   *
+   * @tparam Table transition_table
+   * @tparam SyncPolicy `no_sync`, `msync_batch` or `fdatasync_batch`
+   *
+   * The store keeps the state and the guard of every machine as one
+   * integer, the cell `state * G + guard` (see `machine_snapshot`), in a
+   * file, that is mapped into memory and shared with the kernel page cache.
+   * A transition writes the cell of its machine in place, so the file
+   * always holds the current states, and reopening the file after a restart
+   * recovers them without reading or parsing anything.
+   *
+   * The file starts with a header: a magic number, the fingerprint of the
+   * table, the number of machines and the size of a cell. A file with
+   * another header, or with a cell out of the table, is not opened and is
+   * left untouched; a file, whose initialization was interrupted by a crash,
+   * is initialized again. Cells are in the byte order of the machine.
+   *
+   * Transition actions and predicates are called with the arguments of
+   * `event` and `dispatch`, as by `state_machine`. States and guards are
+   * kept only by their indices.
+   *
+   * A store is used by one thread at a time.
+   */
+  template <class Table, class SyncPolicy = no_sync>
+  class mapped_machine_store {
+  private:
+    using table = __details::compiled_table<Table>;
+
+    static constexpr std::size_t guard_count = table::guard_count;
+
+    using cell_t = __details::least_uint_t<table::cell_count - 1>;
+
+    static constexpr std::uint64_t magic = 0x316d73664d4650ull; // "PFMfsm1"
+
+    struct header {
+      std::uint64_t magic;
+      std::uint64_t fingerprint;
+      std::uint64_t count;
+      std::uint64_t cell_size;
+    };
+
+    static constexpr std::size_t cells_offset = sizeof(header);
+
+    int m_fd = -1;
+    void* m_map = nullptr;
+    std::size_t m_bytes = 0;
+    std::size_t m_count = 0;
+    cell_t* m_cells = nullptr;
+    bool m_recovered = false;
+
+    std::size_t m_pending = 0;
+    std::size_t m_dirty_first = 0;
+    std::size_t m_dirty_last = 0;
+
+    static constexpr cell_t initial_cell =
+        static_cast<cell_t>(table::template guard_index<none>);
+
+    static inline std::size_t file_size(std::size_t count) noexcept {
+      return cells_offset + count * sizeof(cell_t);
+    }
+
+    inline header& head() const noexcept {
+      return *static_cast<header*>(m_map);
+    }
+
+    /*
+     * Tells, if the header was left by a crash, before the initialization of
+     * a file of this store was completed: the magic is not written yet, and
+     * the other fields are either not written yet or match the store.
+     */
+    inline bool unfinished(const header& h) const noexcept {
+      return h.magic == 0 &&
+             (h.fingerprint == 0 || h.fingerprint == table::fingerprint) &&
+             (h.count == 0 || h.count == m_count) &&
+             (h.cell_size == 0 || h.cell_size == sizeof(cell_t));
+    }
+
+    /*
+     * Maps the file of the size m_bytes; on an empty or an unfinished file
+     * writes the header and the initial cells, otherwise checks the header
+     * and the cells.
+     */
+    bool open(const char* path) noexcept {
+      m_fd = ::open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+      if (m_fd < 0) return false;
+
+      struct stat st {};
+      if (fstat(m_fd, &st) != 0) return false;
+      const bool created = st.st_size == 0;
+      if (created && ftruncate(m_fd, static_cast<off_t>(m_bytes)) != 0)
+        return false;
+      if (!created && static_cast<std::size_t>(st.st_size) != m_bytes)
+        return false;
+
+      void* map = mmap(nullptr, m_bytes, PROT_READ | PROT_WRITE, MAP_SHARED,
+                       m_fd, 0);
+      if (map == MAP_FAILED) return false;
+      m_map = map;
+      m_cells = reinterpret_cast<cell_t*>(static_cast<char*>(m_map) +
+                                          cells_offset);
+
+      if (created || unfinished(head())) {
+        for (std::size_t idx = 0; idx < m_count; ++idx)
+          m_cells[idx] = initial_cell;
+        head() = header {0, table::fingerprint, m_count, sizeof(cell_t)};
+        // The magic is written last, so a file, that was not completely
+        // initialized, is never taken for a valid one.
+        msync(m_map, m_bytes, MS_SYNC);
+        head().magic = magic;
+        msync(m_map, m_bytes, MS_SYNC);
+        return true;
+      }
+
+      const header& h = head();
+      if (h.magic != magic || h.fingerprint != table::fingerprint ||
+          h.count != m_count || h.cell_size != sizeof(cell_t))
+        return false;
+
+      // A corrupted cell would index the dispatch table out of its bounds
+      for (std::size_t idx = 0; idx < m_count; ++idx)
+        if (m_cells[idx] >= table::cell_count) return false;
+      m_recovered = true;
+      return true;
+    }
+
+    void close() noexcept {
+      if (m_map) munmap(m_map, m_bytes);
+      if (m_fd >= 0) ::close(m_fd);
+      m_map = nullptr;
+      m_cells = nullptr;
+      m_fd = -1;
+    }
+
+    inline void touch(std::size_t idx) noexcept {
+      if constexpr (SyncPolicy::batch > 0) {
+        if (m_pending == 0) m_dirty_first = m_dirty_last = idx;
+        if (idx < m_dirty_first) m_dirty_first = idx;
+        if (idx > m_dirty_last) m_dirty_last = idx;
+        if (++m_pending == SyncPolicy::batch) flush();
+      }
+    }
+
+    template <typename... Args>
+    bool perform(std::size_t idx, std::size_t event_id, Args&&... args) {
+      cell_t& cell = m_cells[idx];
+      const std::size_t guard = cell % guard_count;
+      const std::size_t tr = __details::check_predicates<Table>(
+          table::lookup(event_id, cell), guard, args...);
+      if (tr == table::no_transition) return false;
+      cell = static_cast<cell_t>(table::targets[tr] * guard_count + guard);
+      touch(idx);
+      __details::action_thunks<Table, Args...>::value[tr](
+          std::forward<Args>(args)...);
+      return true;
+    }
+
+  public:
+    /**
+     * @brief Runtime index of the event Event, that is accepted by
+     * `dispatch`
+     */
+    template <class Event>
+    static constexpr std::size_t event_id = table::template event_index<Event>;
+
+    /**
+     * @brief Opens the store of count machines in the file at path
+     *
+     * A missing, empty or not completely initialized file is created with
+     * every machine in the initial state. An existing file is mapped as is,
+     * if its header matches the table and the number of machines and its
+     * cells are valid; otherwise the store is not opened, see `is_open`.
+     */
+    inline mapped_machine_store(const char* path, std::size_t count) noexcept
+        : m_bytes(file_size(count)), m_count(count) {
+      if (!open(path)) close();
+    }
+
+    mapped_machine_store(const mapped_machine_store&) = delete;
+    mapped_machine_store& operator=(const mapped_machine_store&) = delete;
+
+    /**
+     * @brief Writes the pending transitions, as `flush`, and unmaps the
+     * file
+     */
+    inline ~mapped_machine_store() {
+      if (m_pending) flush();
+      close();
+    }
+
+    /**
+     * @brief Tells, if the file is mapped
+     */
+    inline bool is_open() const noexcept { return m_map != nullptr; }
+
+    /**
+     * @brief Tells, if the states were recovered from an existing file
+     * instead of being initialized
+     */
+    inline bool recovered() const noexcept { return m_recovered; }
+
+    /**
+     * @brief Number of machines in the store, or zero, if it is not open
+     */
+    inline std::size_t size() const noexcept {
+      return is_open() ? m_count : 0;
+    }
+
+    /**
+     * @brief Pass an event to the machine idx
+     *
+     * @tparam Event event
+     * @param idx index of the machine
+     * @param args arguments of the transition action
+     *
+     * @return true, if the event caused a transition
+     */
+    template <class Event, typename... Args>
+    inline bool event(std::size_t idx, Args&&... args) {
+      if constexpr (table::template has_event<Event>)
+        return perform(idx, event_id<Event>, std::forward<Args>(args)...);
+      else
+        return false;
+    }
+
+    /**
+     * @brief Pass an event to the machine idx by the index of the event
+     *
+     * @return true, if the event caused a transition; indices out of the
+     * event collection are ignored
+     */
+    template <typename... Args>
+    inline bool dispatch(std::size_t idx, std::size_t event_id,
+                         Args&&... args) {
+      if (event_id >= table::event_count) return false;
+      return perform(idx, event_id, std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Change the current guard of the machine idx
+     */
+    template <class Guard>
+    inline void guard(std::size_t idx) noexcept {
+      if constexpr (__details::static_check_contains<
+                        Guard, typename Table::guard_collection>()) {
+        const std::size_t cell = m_cells[idx];
+        m_cells[idx] = static_cast<cell_t>(
+            cell - cell % guard_count + table::template guard_index<Guard>);
+        touch(idx);
+      }
+    }
+
+    /**
+     * @brief Index of the current state of the machine idx in the state
+     * collection of the table
+     */
+    inline std::size_t state(std::size_t idx) const noexcept {
+      return m_cells[idx] / guard_count;
+    }
+
+    /**
+     * @brief Checks, if the machine idx is in the state State
+     */
+    template <class State>
+    inline bool is_in(std::size_t idx) const noexcept {
+      return state(idx) == table::template state_index<State>;
+    }
+
+    /**
+     * @brief State and guard of the machine idx, see `state_machine::restore`
+     */
+    inline machine_snapshot snapshot(std::size_t idx) const noexcept {
+      return {table::fingerprint, static_cast<std::uint32_t>(m_cells[idx])};
+    }
+
+    /**
+     * @brief Synchronously writes the changed cells to the file by the sync
+     * policy
+     *
+     * Called by the store after every `SyncPolicy::batch` transitions and
+     * guard changes.
+     */
+    void flush() noexcept {
+      if (!is_open()) return;
+      static const std::size_t page =
+          static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+      std::size_t first = 0;
+      std::size_t last = m_bytes;
+      if (m_pending) {
+        first = (cells_offset + m_dirty_first * sizeof(cell_t)) / page * page;
+        last = cells_offset + (m_dirty_last + 1) * sizeof(cell_t);
+      }
+      SyncPolicy::sync(m_fd, static_cast<char*>(m_map) + first, last - first);
+      m_pending = 0;
+    }
+  };
+
+} // namespace pure
+
+#endif
@@ -0,0 +1,202 @@
+/**
+ * @file metrics.hpp
+ *
+ * File that contains a metrics policy of a State Machine: transition
+ * counters and latency histograms of transition actions.
+ */
+#ifndef PUREFSM_METRICS_HPP
+#define PUREFSM_METRICS_HPP
+
+#include "fsm.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace pure {
+
+  /**
+   * @brief Log-linear bucketing of latencies
+   *
+   * Values below `linear` nanoseconds have a bucket each; every next power
+   * of two is split into `sub_buckets` equal buckets, so the relative error
+   * of a bucket is at most 1 / sub_buckets, and 64-bit values fit into
+   * `bucket_count` buckets.
+   */
+  struct log_linear_buckets {
+    /** @brief Number of buckets per power of two */
+    static constexpr std::size_t sub_buckets = 4;
+
+    /** @brief Values below this one have a bucket each */
+    static constexpr std::size_t linear = 2 * sub_buckets;
+
+    /** @brief Total number of buckets */
+    static constexpr std::size_t bucket_count =
+        linear + (64 - 3) * sub_buckets;
+
+    /**
+     * @brief Bucket of the value
+     */
+    static constexpr std::size_t bucket(std::uint64_t value) noexcept {
+      if (value < linear) return static_cast<std::size_t>(value);
+      std::size_t exponent = 63;
+      while (!(value >> exponent)) --exponent;
+      const auto sub = static_cast<std::size_t>(value >> (exponent - 2)) &
+                       (sub_buckets - 1);
+      return linear + (exponent - 3) * sub_buckets + sub;
+    }
+
+    /**
+     * @brief The smallest value of the bucket
+     */
+    static constexpr std::uint64_t lower_bound(std::size_t bucket) noexcept {
+      if (bucket < linear) return bucket;
+      const std::size_t exponent = (bucket - linear) / sub_buckets + 3;
+      const std::size_t sub = (bucket - linear) % sub_buckets;
+      return (std::uint64_t(sub_buckets) + sub) << (exponent - 2);
+    }
+  };
+
+  /**
+   * @brief Metrics policy of a State Machine
+   *
+   * @tparam Table transition_table of the machine
+   * @tparam Histograms if true, the duration of every performed transition,
+   * including its action, is measured and kept in a log-linear histogram
+   * per transition
+   *
+   * The metrics keep the number of times every transition was performed,
+   * indexed by the position of the transition in the table, and the number
+   * of events, that caused no transition, indexed by the current state and
+   * the event as `state * E + event`, where E is the number of events.
+   *
+   * Counters are updated only by the thread, that runs the machine, with
+   * plain atomic stores, so updates are as cheap as increments of plain
+   * integers. Any thread may take a `snapshot` at any time without a lock;
+   * every counter of the snapshot is exact at some moment of the snapshot,
+   * but the counters are not taken at one moment together.
+   *
+   * Pass it to the machine by reference to scrape it from another thread:
+   *
+   * ```cpp
+   * using metrics_t = pure::transition_metrics<table, true>;
+   * metrics_t metrics;
+   * pure::state_machine<table, pure::empty_logger, metrics_t&> machine(
+   *     pure::empty_logger {}, metrics);
+   * ```
+   */
+  template <class Table, bool Histograms = false>
+  class transition_metrics {
+  private:
+    using table = __details::compiled_table<Table>;
+    using counter_t = std::atomic<std::uint64_t>;
+    using clock = std::chrono::steady_clock;
+
+  public:
+    /** @brief Number of transition counters */
+    static constexpr std::size_t transition_count = table::transition_count;
+
+    /** @brief Number of unhandled event counters */
+    static constexpr std::size_t unhandled_count =
+        table::state_count * table::event_count;
+
+    /** @brief Number of buckets of a latency histogram */
+    static constexpr std::size_t bucket_count =
+        Histograms ? log_linear_buckets::bucket_count : 0;
+
+    /** @brief Histogram of one transition, in nanoseconds */
+    using histogram_t = std::array<std::uint64_t, bucket_count>;
+
+    /**
+     * @brief Copy of all counters
+     */
+    struct snapshot_t {
+      /** @brief Performed transitions, by their index in the table */
+      std::array<std::uint64_t, transition_count> fired;
+
+      /** @brief Unhandled events, by `state * E + event` */
+      std::array<std::uint64_t, unhandled_count> unhandled;
+
+      /** @brief Latency histograms, by the transition index */
+      std::array<histogram_t, Histograms ? transition_count : 0> latency;
+    };
+
+    /**
+     * @brief Index of the unhandled event counter of the event Event in the
+     * state State
+     */
+    template <class State, class Event>
+    static constexpr std::size_t unhandled_index =
+        table::template state_index<State> * table::event_count +
+        table::template event_index<Event>;
+
+  private:
+    std::array<counter_t, transition_count> m_fired {};
+    std::array<counter_t, unhandled_count> m_unhandled {};
+    std::array<std::array<counter_t, bucket_count>,
+               Histograms ? transition_count : 0>
+        m_latency {};
+
+    /* Only the machine thread writes, so no read-modify-write is needed */
+    static inline void increment(counter_t& counter) noexcept {
+      counter.store(counter.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_relaxed);
+    }
+
+  public:
+    transition_metrics() = default;
+
+    transition_metrics(const transition_metrics&) = delete;
+    transition_metrics& operator=(const transition_metrics&) = delete;
+
+    /** @cond undocumented */
+    template <class F>
+    inline void transition(std::size_t tr, F&& perform) {
+      if constexpr (Histograms) {
+        const auto start = clock::now();
+        perform();
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            clock::now() - start);
+        increment(m_latency[tr][log_linear_buckets::bucket(
+            static_cast<std::uint64_t>(ns.count()))]);
+      } else
+        perform();
+      increment(m_fired[tr]);
+    }
+
+    inline void unhandled(std::size_t state, std::size_t event) noexcept {
+      increment(m_unhandled[state * table::event_count + event]);
+    }
+    /** @endcond */
+
+    /**
+     * @brief Number of times the transition with index tr was performed
+     */
+    inline std::uint64_t fired(std::size_t tr) const noexcept {
+      return m_fired[tr].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Takes a copy of all counters; may be called from any thread
+     */
+    snapshot_t snapshot() const noexcept {
+      snapshot_t result {};
+      for (std::size_t idx = 0; idx < transition_count; ++idx)
+        result.fired[idx] = m_fired[idx].load(std::memory_order_relaxed);
+      for (std::size_t idx = 0; idx < unhandled_count; ++idx)
+        result.unhandled[idx] =
+            m_unhandled[idx].load(std::memory_order_relaxed);
+      if constexpr (Histograms)
+        for (std::size_t tr = 0; tr < transition_count; ++tr)
+          for (std::size_t b = 0; b < bucket_count; ++b)
+            result.latency[tr][b] =
+                m_latency[tr][b].load(std::memory_order_relaxed);
+      return result;
+    }
+  };
+
+} // namespace pure
+
+#endif
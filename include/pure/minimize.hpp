@@ -0,0 +1,464 @@
+/**
+ * @file minimize.hpp
+ *
+ * File that contains the compile-time minimization of transition tables.
+ */
+#ifndef PUREFSM_MINIMIZE_HPP
+#define PUREFSM_MINIMIZE_HPP
+
+#include "fsm.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace pure {
+
+  namespace __details {
+
+    /*
+     * has_call_operator tells, if the class T has any operator(), also an
+     * overloaded or a template one: the mixin of T and call_probe has an
+     * ambiguous operator() exactly then.
+     */
+    struct call_probe {
+      void operator()();
+    };
+
+    template <class T>
+    struct call_mixin : T, call_probe {};
+
+    template <class T, typename AlwaysVoid = void>
+    struct has_call_operator : std::true_type {};
+
+    template <class T>
+    struct has_call_operator<
+        T, std::void_t<decltype(&call_mixin<T>::operator())>>
+        : std::false_type {};
+
+    /*
+     * A state may be merged with another one only if it is an empty tag:
+     * it keeps no data and has no state action, so the states differ only
+     * in their names.
+     */
+    template <class State>
+    constexpr bool is_mergeable() noexcept {
+      if constexpr (std::is_class_v<State> && std::is_empty_v<State> &&
+                    !std::is_final_v<State>)
+        return !has_call_operator<State>::value;
+      else
+        return false;
+    }
+
+    template <class Pack>
+    struct pack_indexer;
+
+    template <typename... Ts>
+    struct pack_indexer<tp::type_pack<Ts...>> {
+      template <std::size_t I>
+      using type = pick_t<I, Ts...>;
+    };
+
+    /*
+     * minimizer finds the equivalent states of a table over the dispatch
+     * table of compiled_table. Two states are equivalent, if both are
+     * mergeable and react to every event under every guard with the same
+     * transitions, up to the targets, which must be equivalent too. A
+     * group of equivalent states is represented by its first state.
+     */
+    template <class Table>
+    struct minimizer {
+      using table = compiled_table<Table>;
+      using state_collection = typename Table::state_collection;
+      using transition_pack = typename Table::transitions;
+
+      static constexpr std::size_t state_count = table::state_count;
+      static constexpr std::size_t guard_count = table::guard_count;
+
+      using blocks_t = std::array<std::size_t, state_count>;
+
+    private:
+      template <typename... Ss>
+      static constexpr std::array<bool, sizeof...(Ss)>
+      make_mergeable(tp::type_pack<Ss...>) noexcept {
+        return {is_mergeable<Ss>()...};
+      }
+
+      static constexpr std::array<bool, state_count> mergeable =
+          make_mergeable(state_collection {});
+
+      template <typename... Ts>
+      static tp::type_pack<typename Ts::action_t...>
+          action_pack(tp::type_pack<Ts...>);
+
+      using action_collection =
+          unique_t<decltype(action_pack(transition_pack {}))>;
+
+      template <typename... Ts>
+      static constexpr std::array<std::size_t, sizeof...(Ts)>
+      make_actions(tp::type_pack<Ts...>) noexcept {
+        using action_keys = keys_of<action_collection>;
+        return {action_keys::find(type_key<typename Ts::action_t>(),
+                                  &type_key<typename Ts::action_t>)...};
+      }
+
+      /** Index of the action of every transition in action_collection */
+      static constexpr std::array<std::size_t, table::transition_count>
+          actions = make_actions(transition_pack {});
+
+      /*
+       * The reaction of a state to an event under a guard is the chain of
+       * the transitions, that are tried in their order, up to the first one
+       * without a predicate, or up to no_transition. A symbol is a position
+       * in the chain of an event and a guard, so every state has one
+       * successor by every symbol: the target of the transition at the
+       * position, or the sink node, if there is no transition.
+       */
+      static constexpr std::size_t past = table::transition_count + 1;
+
+      static constexpr std::size_t next(std::size_t tr,
+                                        std::size_t guard) noexcept {
+        if (tr == table::no_transition || !table::predicates[tr]) return past;
+        return table::candidates[tr * guard_count + guard];
+      }
+
+      static constexpr std::size_t chain_length = [] {
+        std::size_t longest = 1;
+        for (std::size_t cell = 0; cell < table::cell_count; ++cell)
+          for (std::size_t event = 0; event < table::event_count; ++event) {
+            std::size_t length = 0;
+            for (std::size_t tr = table::lookup(event, cell); tr != past;
+                 tr = next(tr, cell % guard_count))
+              ++length;
+            longest = length > longest ? length : longest;
+          }
+        return longest;
+      }();
+
+      static constexpr std::size_t symbol_count =
+          table::event_count * guard_count * chain_length;
+
+      static constexpr std::size_t sink = state_count;
+      static constexpr std::size_t node_count = state_count + 1;
+
+      /*
+       * Returns the transition at the position of the symbol, no_transition
+       * at the end of a failed chain, or past beyond the chain.
+       */
+      static constexpr std::size_t element(std::size_t state,
+                                           std::size_t symbol) noexcept {
+        const std::size_t guard = symbol / chain_length % guard_count;
+        std::size_t tr = table::lookup(symbol / chain_length / guard_count,
+                                       state * guard_count + guard);
+        for (std::size_t pos = symbol % chain_length; pos && tr != past; --pos)
+          tr = next(tr, guard);
+        return tr;
+      }
+
+      static constexpr std::size_t successor(std::size_t node,
+                                             std::size_t symbol) noexcept {
+        if (node == sink) return sink;
+        const std::size_t tr = element(node, symbol);
+        return tr < table::transition_count ? table::targets[tr] : sink;
+      }
+
+      /*
+       * Output of a node by a symbol: 0 beyond the chain and for the sink
+       * node, 1 for no_transition, or the action and, for a predicate, the
+       * guard of the transition.
+       */
+      static constexpr std::size_t output(std::size_t node,
+                                          std::size_t symbol) noexcept {
+        if (node == sink) return 0;
+        const std::size_t tr = element(node, symbol);
+        if (tr == past) return 0;
+        if (tr == table::no_transition) return 1;
+        const std::size_t guard =
+            table::predicates[tr] ? table::guards[tr] + 1 : 0;
+        return 2 + actions[tr] * (Table::transition_guards::size() + 1) +
+               guard;
+      }
+
+      static constexpr bool is_mergeable_node(std::size_t node) noexcept {
+        return node != sink && mergeable[node];
+      }
+
+      /*
+       * Inverse of the successors: the predecessors of the node by the
+       * symbol are preds[offsets[symbol * node_count + node]] up to
+       * preds[offsets[symbol * node_count + node + 1]].
+       */
+      struct inverse {
+        std::array<std::size_t, symbol_count * node_count + 1> offsets {};
+        std::array<std::size_t, symbol_count * node_count> preds {};
+      };
+
+      static constexpr inverse make_inverse() noexcept {
+        inverse inv {};
+        for (std::size_t symbol = 0; symbol < symbol_count; ++symbol)
+          for (std::size_t node = 0; node < node_count; ++node)
+            ++inv.offsets[symbol * node_count + successor(node, symbol) + 1];
+        for (std::size_t idx = 1; idx < inv.offsets.size(); ++idx)
+          inv.offsets[idx] += inv.offsets[idx - 1];
+
+        auto fill = inv.offsets;
+        for (std::size_t symbol = 0; symbol < symbol_count; ++symbol)
+          for (std::size_t node = 0; node < node_count; ++node)
+            inv.preds[fill[symbol * node_count + successor(node, symbol)]++] =
+                node;
+        return inv;
+      }
+
+      static constexpr inverse inverse_v = make_inverse();
+
+      /*
+       * Hopcroft's partition refinement. The initial blocks group the
+       * mergeable states with equal outputs by all symbols, other nodes
+       * are alone. A block from the worklist splits every block, that has
+       * both predecessors of the block by a symbol and other nodes; the
+       * smaller part goes to the worklist, unless the split block is
+       * already there. The nodes of a block are contiguous in elems, and
+       * the marked nodes of a block are moved to its front.
+       */
+      static constexpr blocks_t make_blocks() noexcept {
+        constexpr std::size_t n = node_count;
+
+        std::array<std::uint64_t, n> keys {};
+        for (std::size_t node = 0; node < n; ++node) {
+          std::uint64_t hash = 14695981039346656037u;
+          for (std::size_t symbol = 0; symbol < symbol_count; ++symbol)
+            hash = (hash ^ output(node, symbol)) * 1099511628211u;
+          keys[node] = is_mergeable_node(node) ? hash : hash ^ node;
+        }
+
+        const auto same = [&keys](std::size_t lhs, std::size_t rhs) {
+          if (lhs == rhs) return true;
+          if (keys[lhs] != keys[rhs] || !is_mergeable_node(lhs) ||
+              !is_mergeable_node(rhs))
+            return false;
+          for (std::size_t symbol = 0; symbol < symbol_count; ++symbol)
+            if (output(lhs, symbol) != output(rhs, symbol)) return false;
+          return true;
+        };
+        const auto initial = make_key_table(keys, same);
+
+        std::array<std::size_t, n> block_of {};
+        std::array<std::size_t, n> elems {};
+        std::array<std::size_t, n> loc {};
+        std::array<std::size_t, n> first {};
+        std::array<std::size_t, n> end {};
+        std::array<std::size_t, n> marked {};
+        std::array<bool, n> in_work {};
+        std::array<std::size_t, n> work {};
+        std::array<std::size_t, n> members {};
+        std::array<std::size_t, n> pre {};
+        std::array<std::size_t, n> touched {};
+        std::size_t block_count = 0;
+        std::size_t work_size = 0;
+
+        for (std::size_t node = 0; node < n; ++node) {
+          const std::size_t head = initial.find(
+              keys[node], [&](std::size_t pos) { return same(pos, node); });
+          block_of[node] = head == node ? block_count++ : block_of[head];
+          ++end[block_of[node]];
+        }
+        for (std::size_t block = 0, pos = 0; block < block_count; ++block) {
+          first[block] = pos;
+          pos += end[block];
+          end[block] = first[block];
+          work[work_size++] = block;
+          in_work[block] = true;
+        }
+        for (std::size_t node = 0; node < n; ++node) {
+          loc[node] = end[block_of[node]]++;
+          elems[loc[node]] = node;
+        }
+
+        constexpr auto& inv = inverse_v;
+        while (work_size) {
+          const std::size_t splitter = work[--work_size];
+          in_work[splitter] = false;
+          const std::size_t member_count = end[splitter] - first[splitter];
+          for (std::size_t idx = 0; idx < member_count; ++idx)
+            members[idx] = elems[first[splitter] + idx];
+
+          for (std::size_t symbol = 0; symbol < symbol_count; ++symbol) {
+            std::size_t pre_count = 0;
+            for (std::size_t idx = 0; idx < member_count; ++idx) {
+              const std::size_t row = symbol * n + members[idx];
+              for (std::size_t p = inv.offsets[row];
+                   p < inv.offsets[row + 1]; ++p)
+                pre[pre_count++] = inv.preds[p];
+            }
+
+            std::size_t touched_count = 0;
+            for (std::size_t idx = 0; idx < pre_count; ++idx) {
+              const std::size_t node = pre[idx];
+              const std::size_t block = block_of[node];
+              if (marked[block] == 0) touched[touched_count++] = block;
+              const std::size_t pos = first[block] + marked[block]++;
+              const std::size_t other = elems[pos];
+              elems[loc[node]] = other;
+              loc[other] = loc[node];
+              elems[pos] = node;
+              loc[node] = pos;
+            }
+
+            for (std::size_t idx = 0; idx < touched_count; ++idx) {
+              const std::size_t block = touched[idx];
+              const std::size_t size = end[block] - first[block];
+              if (marked[block] < size) {
+                const std::size_t split = block_count++;
+                first[split] = first[block];
+                end[split] = first[block] + marked[block];
+                first[block] = end[split];
+                for (std::size_t pos = first[split]; pos < end[split]; ++pos)
+                  block_of[elems[pos]] = split;
+
+                std::size_t smaller = split;
+                if (!in_work[block] && size - marked[block] < marked[block])
+                  smaller = block;
+                work[work_size++] = smaller;
+                in_work[smaller] = true;
+              }
+              marked[block] = 0;
+            }
+          }
+        }
+
+        // A block is numbered by its first state
+        std::array<std::size_t, n> reps {};
+        for (auto& rep : reps) rep = n;
+        blocks_t blocks {};
+        for (std::size_t state = 0; state < state_count; ++state) {
+          auto& rep = reps[block_of[state]];
+          if (rep == n) rep = state;
+          blocks[state] = rep;
+        }
+        return blocks;
+      }
+
+    public:
+      /** Representative of the block of every state */
+      static constexpr blocks_t blocks = make_blocks();
+
+      template <std::size_t State>
+      using state_t = typename pack_indexer<
+          state_collection>::template type<blocks[State]>;
+
+    private:
+      static constexpr std::size_t kept_count = [] {
+        std::size_t count = 0;
+        for (std::size_t tr = 0; tr < table::transition_count; ++tr)
+          count += blocks[table::sources[tr]] == table::sources[tr];
+        return count;
+      }();
+
+      /* Transitions, whose sources are representatives */
+      static constexpr std::array<std::size_t, kept_count> kept = [] {
+        std::array<std::size_t, kept_count> kept {};
+        std::size_t idx = 0;
+        for (std::size_t tr = 0; tr < table::transition_count; ++tr)
+          if (blocks[table::sources[tr]] == table::sources[tr])
+            kept[idx++] = tr;
+        return kept;
+      }();
+
+      template <std::size_t Tr>
+      using transition_t =
+          typename pack_indexer<transition_pack>::template type<Tr>;
+
+      template <std::size_t Tr>
+      using rebound_t =
+          transition<typename transition_t<Tr>::source_t,
+                     typename transition_t<Tr>::event_t,
+                     state_t<table::targets[Tr]>,
+                     typename transition_t<Tr>::action_t,
+                     typename transition_t<Tr>::guard_t>;
+
+      template <std::size_t... Is>
+      static tp::type_pack<rebound_t<kept[Is]>...>
+          rebind(std::index_sequence<Is...>);
+
+    public:
+      using transitions =
+          decltype(rebind(std::make_index_sequence<kept_count> {}));
+
+      using initial = tp::type_pack<state_t<0>>;
+    };
+
+  } // namespace __details
+
+  /**
+   * @brief Minimal transition table, equivalent to the table Table
+   *
+   * Equivalent states of Table are merged at compile time: states that are
+   * empty tags without state actions, and that react to every event under
+   * every guard with the same actions and guard predicates, leading to
+   * equivalent states. The first state of every group of equivalent states
+   * stays in the table and represents the others. The events and the guards
+   * are kept as in Table, so their indices do not change:
+   *
+   * ```cpp
+   * using table = pure::minimize<generated_table>;
+   * pure::state_machine<table> machine;
+   * using state_t = table::state_t<Copy>; // the representative of Copy
+   * ```
+   *
+   * States that keep data or have state actions are never merged.
+   */
+  template <class Table>
+  struct minimize : __details::table_collections<
+                        typename __details::minimizer<Table>::transitions,
+                        typename __details::minimizer<Table>::initial> {
+    /** @cond undocumented */
+    using transition_guards = typename Table::transition_guards;
+    using guards = typename Table::guards;
+    using event_collection = typename Table::event_collection;
+    using guard_collection = typename Table::guard_collection;
+    using event_v = typename Table::event_v;
+    using guard_v = typename Table::guard_v;
+    /** @endcond */
+
+  private:
+    using minimizer = __details::minimizer<Table>;
+    using original_states = typename Table::state_collection;
+    using states = typename minimize::state_collection;
+
+    template <typename... Ss>
+    static constexpr std::array<std::size_t, sizeof...(Ss)>
+    make_state_map(tp::type_pack<Ss...>) noexcept {
+      using state_keys = __details::keys_of<states>;
+      const std::array<std::size_t, sizeof...(Ss)> found = {state_keys::find(
+          __details::type_key<Ss>(), &__details::type_key<Ss>)...};
+      std::array<std::size_t, sizeof...(Ss)> map {};
+      for (std::size_t state = 0; state < map.size(); ++state)
+        map[state] = found[minimizer::blocks[state]];
+      return map;
+    }
+
+  public:
+    /** @brief Original table */
+    using original_table = Table;
+
+    /**
+     * @brief State of the minimal table, that represents the state State of
+     * the original table
+     */
+    template <class State>
+    using state_t = typename minimizer::template state_t<
+        __details::index_of<State>(original_states {})>;
+
+    /**
+     * @brief Index in the minimal state collection of the representative
+     * of every state of the original state collection
+     */
+    static constexpr std::array<std::size_t, original_states::size()>
+        state_map = make_state_map(original_states {});
+  };
+
+} // namespace pure
+
+#endif
@@ -0,0 +1,337 @@
+/**
+ * @file multi_guard.hpp
+ *
+ * File that contains a State Machine, which may have several guards active
+ * at once.
+ */
+#ifndef PUREFSM_MULTI_GUARD_HPP
+#define PUREFSM_MULTI_GUARD_HPP
+
+#include "fsm.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace pure {
+
+  namespace __details {
+
+    template <std::size_t Bits>
+    using least_bits_t = std::conditional_t<
+        Bits <= 8, std::uint8_t,
+        std::conditional_t<
+            Bits <= 16, std::uint16_t,
+            std::conditional_t<Bits <= 32, std::uint32_t, std::uint64_t>>>;
+
+    /*
+     * Condition of a transition guard over the set of active guards:
+     * the transition matches, if ((active & mask) != 0) != negate.
+     *
+     * - a plain guard G: mask is the bit of G, negate is false;
+     * - any_of: mask is the union of bits, negate is false;
+     * - none_of: mask is the union of bits, negate is true;
+     * - none and predicates: mask is empty, negate is true, so it always
+     *   matches; a predicate is checked afterwards.
+     */
+    template <class Bits>
+    struct guard_condition {
+      Bits mask;
+      bool negate;
+    };
+
+  } // namespace __details
+
+  /**
+   * @brief State Machine with a set of active guards
+   *
+   * @tparam Table transition_table
+   * @tparam Logger type that provides a logger interface
+   *
+   * Unlike `state_machine`, which has exactly one current guard, this
+   * machine keeps the set of active guards as a bitset, one bit per guard
+   * of the table (up to 64 guards). Guards are set and cleared
+   * independently, each by one bit operation.
+   *
+   * The guard of every transition is compiled into a constant mask:
+   *
+   * - a transition with a guard `G` matches, if G is active;
+   * - with `any_of<Gs...>`, if any of Gs is active;
+   * - with `none_of<Gs...>`, if none of Gs is active;
+   * - with `none`, always;
+   * - with a predicate `when<P>`, if P holds for the event arguments.
+   *
+   * So the guard check is a single AND and a compare. The `none` guard is
+   * active, while no other guard is active.
+   *
+   * Transitions are grouped by their source state and event at compile
+   * time; an event checks only the transitions of the current state and
+   * this event, in the order of the table, and performs the first matching
+   * one.
+   */
+  template <class Table, class Logger = empty_logger>
+  class multi_guard_machine : private __details::logger_holder<Logger> {
+  private:
+    using table = __details::compiled_table<Table>;
+    using logger_t = Logger;
+    using holder_t = __details::logger_holder<Logger>;
+    using transition_pack = typename Table::transitions;
+    using guard_collection = typename Table::guard_collection;
+
+    static constexpr std::size_t state_count = table::state_count;
+    static constexpr std::size_t event_count = table::event_count;
+    static constexpr std::size_t transition_count = table::transition_count;
+
+    static_assert(table::guard_count <= 64,
+                  "Multi-guard machine supports up to 64 guards");
+
+  public:
+    /** @brief Bitset of active guards */
+    using guards_t = __details::least_bits_t<table::guard_count>;
+
+  private:
+    using state_t = __details::least_uint_t<state_count - 1>;
+    using condition_t = __details::guard_condition<guards_t>;
+
+    state_t m_state = 0;
+    guards_t m_guards = bit<none>;
+
+    template <class Guard>
+    static constexpr guards_t bit =
+        guards_t(1) << table::template guard_index<Guard>;
+
+    template <typename... Gs>
+    static constexpr guards_t bits(tp::type_pack<Gs...>) noexcept {
+      return (guards_t(0) | ... | bit<Gs>);
+    }
+
+    template <class Guard>
+    static constexpr condition_t condition_of() noexcept {
+      if constexpr (std::is_same_v<Guard, none> ||
+                    __details::is_predicate_guard<Guard>::value)
+        return {0, true};
+      else if constexpr (__details::is_logical_guard<Guard>::value)
+        return {bits(typename Guard::guard_pack {}),
+                Guard::type == __details::guard_class::noneof};
+      else
+        return {bit<Guard>, false};
+    }
+
+    template <typename... Ts>
+    static constexpr std::array<condition_t, sizeof...(Ts)>
+    make_conditions(tp::type_pack<Ts...>) noexcept {
+      return {condition_of<typename Ts::guard_t>()...};
+    }
+
+    /*
+     * Transitions grouped by (event, source state): the transitions of the
+     * group `event * S + state` are items[offsets[group]] ...
+     * items[offsets[group + 1] - 1], in the order of the table.
+     */
+    struct groups_t {
+      std::array<std::size_t, event_count * state_count + 1> offsets {};
+      std::array<std::size_t, transition_count> items {};
+    };
+
+    static constexpr groups_t make_groups() noexcept {
+      groups_t groups {};
+      for (std::size_t tr = 0; tr < transition_count; ++tr)
+        ++groups.offsets[table::events[tr] * state_count +
+                         table::sources[tr] + 1];
+      for (std::size_t group = 0; group < event_count * state_count; ++group)
+        groups.offsets[group + 1] += groups.offsets[group];
+
+      std::array<std::size_t, event_count * state_count + 1> fill =
+          groups.offsets;
+      for (std::size_t tr = 0; tr < transition_count; ++tr)
+        groups.items[fill[table::events[tr] * state_count +
+                          table::sources[tr]]++] = tr;
+      return groups;
+    }
+
+    struct compiled {
+      static constexpr auto conditions = make_conditions(transition_pack {});
+      static constexpr groups_t groups = make_groups();
+    };
+
+    using state_writers =
+        __details::type_writers<logger_t, typename Table::state_collection>;
+
+    template <typename... Args>
+    struct actions {
+      template <typename... Ts>
+      static constexpr std::array<bool, sizeof...(Ts)>
+      make(tp::type_pack<Ts...>) noexcept {
+        return {std::is_invocable_v<typename Ts::action_t, Args...>...};
+      }
+
+      static constexpr auto value = make(transition_pack {});
+    };
+
+    /*
+     * Performs the transition with index tr: changes the state to its target
+     * and calls its action.
+     */
+    template <typename... Args>
+    inline void transit(std::size_t tr, Args&&... args) {
+      if constexpr (!__details::is_empty_logger_v<logger_t>)
+        state_writers::value[table::targets[tr]](this->logger(),
+                                                 "Change state to ");
+      m_state = static_cast<state_t>(table::targets[tr]);
+      if (actions<Args...>::value[tr]) {
+        this->logger().write("Calling an action...");
+        __details::action_thunks<Table, Args...>::value[tr](
+            std::forward<Args>(args)...);
+      }
+    }
+
+    /*
+     * Returns the index of the first transition of the current state by the
+     * event, whose guard condition and predicate hold, or transition_count.
+     */
+    template <typename... Args>
+    inline std::size_t find(std::size_t event_id, Args&... args) const {
+      constexpr auto& conditions = compiled::conditions;
+      constexpr auto& groups = compiled::groups;
+      const std::size_t group = event_id * state_count + m_state;
+      for (std::size_t idx = groups.offsets[group];
+           idx < groups.offsets[group + 1]; ++idx) {
+        const std::size_t tr = groups.items[idx];
+        const auto& cond = conditions[tr];
+        if (((m_guards & cond.mask) != 0) == cond.negate) continue;
+        if constexpr (table::has_predicates) {
+          if (table::predicates[tr] &&
+              !__details::predicate_thunks<Table, Args...>::value[tr](args...))
+            continue;
+        }
+        return tr;
+      }
+      return transition_count;
+    }
+
+  public:
+    /**
+     * @brief Runtime index of the event Event, that is accepted by
+     * `dispatch`
+     */
+    template <class Event>
+    static constexpr std::size_t event_id = table::template event_index<Event>;
+
+    inline multi_guard_machine() = default;
+
+    /**
+     * @brief Constructor that allows to initialize a logger
+     */
+    inline multi_guard_machine(logger_t custom_logger)
+        : holder_t(std::move(custom_logger)) {}
+
+    /**
+     * @brief Pass an event to a State Machine
+     *
+     * @tparam Event event
+     * @tparam Args... variadic template type pack of arguments
+     */
+    template <typename Event, typename... Args>
+    void event(Args&&... args) {
+      this->logger().template write<Event>("New event: ");
+      if constexpr (table::template has_event<Event>) {
+        const std::size_t tr = find(event_id<Event>, args...);
+        if (tr != transition_count)
+          transit(tr, std::forward<Args>(args)...);
+      }
+    }
+
+    /**
+     * @brief Pass an event to a State Machine by its runtime index
+     *
+     * @return true, if the event caused a transition
+     */
+    template <typename... Args>
+    bool dispatch(std::size_t event_id, Args&&... args) {
+      if (event_id >= event_count) return false;
+      const std::size_t tr = find(event_id, args...);
+      if (tr == transition_count) return false;
+      transit(tr, std::forward<Args>(args)...);
+      return true;
+    }
+
+    /**
+     * @brief Calls a state action
+     *
+     * If the current state type is a functor and it is can be called with the
+     * given arguments, it will be called.
+     */
+    template <typename... Args>
+    void action(Args&&... args) {
+      using state_actions = __details::state_actions<Table, logger_t, Args...>;
+      state_actions::value[m_state](this->logger(),
+                                    std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Make Guard the only active guard
+     *
+     * `guard<none>()` clears all guards.
+     */
+    template <class Guard>
+    inline void guard() {
+      if constexpr (__details::static_check_contains<Guard,
+                                                     guard_collection>()) {
+        this->logger().template write<Guard>("New guard: ");
+        m_guards = bit<Guard>;
+      }
+    }
+
+    /**
+     * @brief Activate the guard, keeping the other active guards
+     *
+     * `set_guard<none>()` clears all guards.
+     */
+    template <class Guard>
+    inline void set_guard() {
+      if constexpr (__details::static_check_contains<Guard,
+                                                     guard_collection>()) {
+        this->logger().template write<Guard>("Set guard: ");
+        if constexpr (std::is_same_v<Guard, none>)
+          m_guards = bit<none>;
+        else
+          m_guards = static_cast<guards_t>((m_guards & ~bit<none>) |
+                                           bit<Guard>);
+      }
+    }
+
+    /**
+     * @brief Deactivate the guard
+     */
+    template <class Guard>
+    inline void clear_guard() {
+      if constexpr (__details::static_check_contains<Guard,
+                                                     guard_collection>()) {
+        this->logger().template write<Guard>("Clear guard: ");
+        if constexpr (!std::is_same_v<Guard, none>) {
+          m_guards = static_cast<guards_t>(m_guards & ~bit<Guard>);
+          if (!m_guards) m_guards = bit<none>;
+        }
+      }
+    }
+
+    /**
+     * @brief Checks, if the guard is active
+     */
+    template <class Guard>
+    inline bool is_set() const noexcept {
+      return m_guards & bit<Guard>;
+    }
+
+    /**
+     * @brief Bitset of active guards, bit i is the guard with index i in the
+     * guard collection of the table
+     */
+    inline guards_t guards() const noexcept { return m_guards; }
+  };
+
+} // namespace pure
+
+#endif
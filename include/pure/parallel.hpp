@@ -0,0 +1,248 @@
+/**
+ * @file parallel.hpp
+ *
+ * File that contains a State Machine with orthogonal regions, which react
+ * to the same events.
+ */
+#ifndef PUREFSM_PARALLEL_HPP
+#define PUREFSM_PARALLEL_HPP
+
+#include "fsm.hpp"
+
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace pure {
+
+  namespace __details {
+
+    template <class Table>
+    using region_cell_t = least_uint_t<compiled_table<Table>::cell_count - 1>;
+
+    /*
+     * region_events maps every event of the common event collection to its
+     * index in the event collection of the region Table, or to the number
+     * of the region events, if the region has no transitions by it.
+     */
+    template <class Table, class Events>
+    struct region_events;
+
+    template <class Table, typename... Es>
+    struct region_events<Table, tp::type_pack<Es...>> {
+      static constexpr std::array<std::size_t, sizeof...(Es)> value = {
+          compiled_table<Table>::template event_index<Es>...};
+    };
+
+  } // namespace __details
+
+  /**
+   * @brief State Machine with orthogonal regions
+   *
+   * @tparam Tables transition tables of the regions
+   *
+   * Every region is a State Machine with its own table, state and guard.
+   * The cells of all regions (`state * G + guard`, see `machine_snapshot`)
+   * are kept together in one small object, and an event is passed to all
+   * regions in one call: every region looks its transition up in its own
+   * dispatch table. Regions, whose tables have no transitions by a static
+   * event, are skipped at compile time.
+   *
+   * Regions react to an event in the order of the tables. Actions are
+   * called with the arguments of the event as lvalues, since they are
+   * shared by all regions.
+   *
+   * States and guards are kept only by their indices: a state action is
+   * called on a default constructed state, so data members of states are
+   * not kept between the calls.
+   */
+  template <class... Tables>
+  class parallel_machine {
+    static_assert(sizeof...(Tables) > 0,
+                  "Parallel machine must have at least one region");
+
+  private:
+    template <std::size_t R>
+    using table_t = __details::pick_t<R, Tables...>;
+
+    template <std::size_t R>
+    using compiled_t = __details::compiled_table<table_t<R>>;
+
+    using regions = std::index_sequence_for<Tables...>;
+
+    // Common collection of the events of all regions
+    using events = __details::unique_t<
+        __details::join_t<typename Tables::event_collection...>>;
+
+    std::tuple<__details::region_cell_t<Tables>...> m_cells {
+        static_cast<__details::region_cell_t<Tables>>(
+            __details::compiled_table<Tables>::template guard_index<none>)...};
+
+    /*
+     * Passes the event with the index event_id in the region R.
+     */
+    template <std::size_t R, typename... Args>
+    inline bool step(std::size_t event_id, Args&... args) {
+      using table = compiled_t<R>;
+      auto& cell = std::get<R>(m_cells);
+      const std::size_t guard = cell % table::guard_count;
+      const std::size_t tr = __details::check_predicates<table_t<R>>(
+          table::lookup(event_id, cell), guard, args...);
+      if (tr == table::no_transition) return false;
+      cell = static_cast<std::remove_reference_t<decltype(cell)>>(
+          table::targets[tr] * table::guard_count + guard);
+      __details::action_thunks<table_t<R>, Args&...>::value[tr](args...);
+      return true;
+    }
+
+    template <class Event, std::size_t R, typename... Args>
+    inline std::size_t region_event(Args&... args) {
+      if constexpr (compiled_t<R>::template has_event<Event>)
+        return step<R>(compiled_t<R>::template event_index<Event>, args...);
+      else
+        return 0;
+    }
+
+    template <class Event, std::size_t... Rs, typename... Args>
+    inline std::size_t event_impl(std::index_sequence<Rs...>,
+                                  Args&... args) {
+      std::size_t fired = 0;
+      ((fired += region_event<Event, Rs>(args...)), ...);
+      return fired;
+    }
+
+    template <std::size_t R, typename... Args>
+    inline std::size_t region_dispatch(std::size_t event_id, Args&... args) {
+      const std::size_t id =
+          __details::region_events<table_t<R>, events>::value[event_id];
+      return id < compiled_t<R>::event_count ? step<R>(id, args...) : 0;
+    }
+
+    template <std::size_t... Rs, typename... Args>
+    inline std::size_t dispatch_impl(std::index_sequence<Rs...>,
+                                     std::size_t event_id, Args&... args) {
+      std::size_t fired = 0;
+      ((fired += region_dispatch<Rs>(event_id, args...)), ...);
+      return fired;
+    }
+
+    template <class Guard, std::size_t R>
+    inline void region_guard() noexcept {
+      using guards = typename table_t<R>::guard_collection;
+      if constexpr (tp::contains<Guard, guards>::value) {
+        using table = compiled_t<R>;
+        auto& cell = std::get<R>(m_cells);
+        cell = static_cast<std::remove_reference_t<decltype(cell)>>(
+            cell - cell % table::guard_count +
+            table::template guard_index<Guard>);
+      }
+    }
+
+    template <class Guard, std::size_t... Rs>
+    inline void guard_impl(std::index_sequence<Rs...>) noexcept {
+      (region_guard<Guard, Rs>(), ...);
+    }
+
+    template <class State, std::size_t... Rs>
+    inline bool is_in_impl(std::index_sequence<Rs...>) const noexcept {
+      return (... || is_in<Rs, State>());
+    }
+
+    template <std::size_t... Rs, typename... Args>
+    inline void action_impl(std::index_sequence<Rs...>, Args&... args) {
+      empty_logger logger;
+      (__details::state_actions<table_t<Rs>, empty_logger, Args&...>::value
+           [state<Rs>()](logger, args...),
+       ...);
+    }
+
+  public:
+    /** @brief Number of the regions */
+    static constexpr std::size_t region_count = sizeof...(Tables);
+
+    /**
+     * @brief Runtime index of the event Event in the common event
+     * collection of all regions, that is accepted by `dispatch`
+     */
+    template <class Event>
+    static constexpr std::size_t event_id =
+        __details::index_of<Event>(events {});
+
+    /**
+     * @brief Pass an event to all regions
+     *
+     * @return the number of regions, that performed a transition
+     */
+    template <class Event, typename... Args>
+    inline std::size_t event(Args&&... args) {
+      return event_impl<Event>(regions {}, args...);
+    }
+
+    /**
+     * @brief Pass an event to all regions by its runtime index
+     *
+     * @return the number of regions, that performed a transition; indices
+     * out of the common event collection are ignored
+     */
+    template <typename... Args>
+    inline std::size_t dispatch(std::size_t event_id, Args&&... args) {
+      if (event_id >= events::size()) return 0;
+      return dispatch_impl(regions {}, event_id, args...);
+    }
+
+    /**
+     * @brief Change the current guard of every region, that has the guard
+     * Guard
+     */
+    template <class Guard>
+    inline void guard() noexcept {
+      static_assert(
+          (... ||
+           tp::contains<Guard, typename Tables::guard_collection>::value),
+          "No region has the guard");
+      guard_impl<Guard>(regions {});
+    }
+
+    /**
+     * @brief Calls the state action of the current state of every region
+     */
+    template <typename... Args>
+    inline void action(Args&&... args) {
+      action_impl(regions {}, args...);
+    }
+
+    /**
+     * @brief Index of the current state of the region R in the state
+     * collection of its table
+     */
+    template <std::size_t R>
+    inline std::size_t state() const noexcept {
+      return std::get<R>(m_cells) / compiled_t<R>::guard_count;
+    }
+
+    /**
+     * @brief Checks, if the region R is in the state State
+     */
+    template <std::size_t R, class State>
+    inline bool is_in() const noexcept {
+      using states = typename table_t<R>::state_collection;
+      if constexpr (tp::contains<State, states>::value)
+        return state<R>() == compiled_t<R>::template state_index<State>;
+      else
+        return false;
+    }
+
+    /**
+     * @brief Checks, if any region is in the state State
+     */
+    template <class State>
+    inline bool is_in() const noexcept {
+      return is_in_impl<State>(regions {});
+    }
+  };
+
+} // namespace pure
+
+#endif
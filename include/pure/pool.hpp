@@ -0,0 +1,418 @@
+/**
+ * @file pool.hpp
+ *
+ * File that contains a pool of State Machines, that share one transition
+ * table.
+ */
+#ifndef PUREFSM_POOL_HPP
+#define PUREFSM_POOL_HPP
+
+#include "fsm.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSSE3__) || defined(__AVX2__)
+  #include <immintrin.h>
+#endif
+
+namespace pure {
+
+  /**
+   * @brief Fixed-size set of bits, which exposes its 64-bit words
+   *
+   * @tparam N number of bits
+   */
+  template <std::size_t N>
+  class bitmask {
+  public:
+    /** @brief Number of 64-bit words */
+    static constexpr std::size_t word_count = (N + 63) / 64;
+
+  private:
+    std::array<std::uint64_t, word_count> m_words {};
+
+  public:
+    static constexpr std::size_t size() noexcept { return N; }
+
+    inline bool test(std::size_t pos) const noexcept {
+      return (m_words[pos / 64] >> (pos % 64)) & 1u;
+    }
+
+    inline void set(std::size_t pos) noexcept {
+      m_words[pos / 64] |= std::uint64_t(1) << (pos % 64);
+    }
+
+    inline void reset(std::size_t pos) noexcept {
+      m_words[pos / 64] &= ~(std::uint64_t(1) << (pos % 64));
+    }
+
+    /**
+     * @brief Sets all N bits
+     */
+    inline void set() noexcept {
+      for (auto& word : m_words) word = ~std::uint64_t(0);
+      if constexpr (N % 64 != 0)
+        m_words[word_count - 1] = (std::uint64_t(1) << (N % 64)) - 1;
+    }
+
+    /**
+     * @brief Resets all bits
+     */
+    inline void reset() noexcept {
+      for (auto& word : m_words) word = 0;
+    }
+
+    inline std::size_t count() const noexcept {
+      std::size_t result = 0;
+      for (auto word : m_words)
+        result += static_cast<std::size_t>(__builtin_popcountll(word));
+      return result;
+    }
+
+    inline std::uint64_t word(std::size_t idx) const noexcept {
+      return m_words[idx];
+    }
+
+    inline std::uint64_t& word(std::size_t idx) noexcept {
+      return m_words[idx];
+    }
+  };
+
+  /**
+   * @brief Pool of State Machines with the same transition table
+   *
+   * @tparam Table transition_table
+   * @tparam Capacity number of machines in the pool
+   *
+   * The pool keeps the state and the guard of every machine as one integer,
+   * the cell `state * G + guard`, where G is the number of guards. Cells of
+   * all machines are stored in one contiguous array, so an event is applied
+   * to all machines (or to a subset, given by a mask) as a table lookup
+   * over that array:
+   *
+   * - if the table has at most 16 cells, the lookup is done by byte
+   *   shuffles, 16 machines at a time with SSSE3 or 32 with AVX2;
+   * - otherwise, if a cell fits into a byte, by AVX2 gathers, 8 machines at
+   *   a time;
+   * - otherwise, and if neither SSSE3 nor AVX2 is enabled, by a scalar loop.
+   *
+   * Transition actions are not called. Instead, every event application may
+   * report the machines, which performed a transition, in a bitmask.
+   */
+  template <class Table, std::size_t Capacity>
+  class state_machine_pool {
+  private:
+    static_assert(Capacity > 0, "Pool must hold at least one machine");
+
+    using table = __details::compiled_table<Table>;
+
+    static_assert(!table::has_predicates,
+                  "Pool machines do not support predicate guards");
+
+    static constexpr std::size_t guard_count = table::guard_count;
+    static constexpr std::size_t cell_count = table::cell_count;
+
+    using cell_t = __details::least_uint_t<cell_count - 1>;
+
+    static constexpr bool byte_cells = sizeof(cell_t) == 1;
+
+    /*
+     * Transition of all cells by the event Event: the next cell and the
+     * flag, if the transition is performed. The arrays are padded to 16
+     * entries for the byte shuffle.
+     */
+    template <class Event>
+    struct event_row {
+      static constexpr std::size_t size = cell_count < 16 ? 16 : cell_count;
+
+      struct arrays {
+        std::array<cell_t, size> next {};
+        std::array<std::uint8_t, size> fired {};
+        std::array<std::int32_t, size> next32 {};
+        std::array<std::int32_t, size> fired32 {};
+      };
+
+      static constexpr arrays make() noexcept {
+        arrays result {};
+        for (std::size_t cell = 0; cell < size; ++cell) {
+          std::size_t next = cell;
+          bool fired = false;
+          if (cell < cell_count) {
+            const auto tr =
+                table::lookup(table::template event_index<Event>, cell);
+            if (tr != table::no_transition) {
+              next = table::targets[tr] * guard_count + cell % guard_count;
+              fired = true;
+            }
+          }
+          result.next[cell] = static_cast<cell_t>(next);
+          result.fired[cell] = fired ? 0xFF : 0;
+          result.next32[cell] = static_cast<std::int32_t>(next);
+          result.fired32[cell] = fired ? -1 : 0;
+        }
+        return result;
+      }
+
+      static constexpr arrays value = make();
+    };
+
+  public:
+    /** @brief Mask of machines in the pool */
+    using mask_t = bitmask<Capacity>;
+
+  private:
+    alignas(32) std::array<cell_t, Capacity> m_cells;
+
+    /*
+     * Returns `width` bits of the mask, starting at pos; pos is a multiple
+     * of width and width divides 64.
+     */
+    static inline std::uint64_t bits(const mask_t& mask, std::size_t pos,
+                                     std::size_t width) noexcept {
+      const std::uint64_t all = width == 64 ? ~std::uint64_t(0)
+                                            : (std::uint64_t(1) << width) - 1;
+      return (mask.word(pos / 64) >> (pos % 64)) & all;
+    }
+
+    static inline void put_bits(mask_t* mask, std::size_t pos,
+                                std::uint64_t value) noexcept {
+      if (mask) mask->word(pos / 64) |= value << (pos % 64);
+    }
+
+    template <class Event, bool Masked>
+    inline std::size_t scalar(std::size_t first, const mask_t* selected,
+                              mask_t* fired) noexcept {
+      constexpr auto& row = event_row<Event>::value;
+      std::size_t count = 0;
+      for (std::size_t i = first; i < Capacity; ++i) {
+        if constexpr (Masked)
+          if (!selected->test(i)) continue;
+        const cell_t cell = m_cells[i];
+        m_cells[i] = row.next[cell];
+        if (row.fired[cell]) {
+          ++count;
+          if (fired) fired->set(i);
+        }
+      }
+      return count;
+    }
+
+#if defined(__AVX2__)
+    template <class Event, bool Masked>
+    inline std::size_t shuffle(std::size_t& i, const mask_t* selected,
+                               mask_t* fired) noexcept {
+      constexpr auto& row = event_row<Event>::value;
+      const __m256i next = _mm256_broadcastsi128_si256(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(row.next.data())));
+      const __m256i fire = _mm256_broadcastsi128_si256(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(row.fired.data())));
+      const __m256i spread =
+          _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2,
+                           2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+      const __m256i select = _mm256_set1_epi64x(
+          static_cast<long long>(0x8040201008040201ull));
+
+      std::size_t count = 0;
+      for (; i + 32 <= Capacity; i += 32) {
+        auto* ptr = reinterpret_cast<__m256i*>(m_cells.data() + i);
+        const __m256i cells = _mm256_load_si256(ptr);
+        __m256i next_cells = _mm256_shuffle_epi8(next, cells);
+        __m256i fired_cells = _mm256_shuffle_epi8(fire, cells);
+        if constexpr (Masked) {
+          const auto sel = static_cast<int>(bits(*selected, i, 32));
+          __m256i mask =
+              _mm256_shuffle_epi8(_mm256_set1_epi32(sel), spread);
+          mask = _mm256_cmpeq_epi8(_mm256_and_si256(mask, select), select);
+          next_cells = _mm256_blendv_epi8(cells, next_cells, mask);
+          fired_cells = _mm256_and_si256(fired_cells, mask);
+        }
+        _mm256_store_si256(ptr, next_cells);
+        const auto f = static_cast<std::uint32_t>(
+            _mm256_movemask_epi8(fired_cells));
+        count += static_cast<std::size_t>(__builtin_popcount(f));
+        put_bits(fired, i, f);
+      }
+      return count;
+    }
+
+    template <class Event, bool Masked>
+    inline std::size_t gather(std::size_t& i, const mask_t* selected,
+                              mask_t* fired) noexcept {
+      constexpr auto& row = event_row<Event>::value;
+      const __m256i select = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+      const __m256i low_bytes = _mm256_setr_epi8(
+          0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 4,
+          8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+      const __m256i join = _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0);
+
+      std::size_t count = 0;
+      for (; i + 8 <= Capacity; i += 8) {
+        auto* ptr = reinterpret_cast<__m128i*>(m_cells.data() + i);
+        const __m256i cells = _mm256_cvtepu8_epi32(_mm_loadl_epi64(ptr));
+        __m256i next_cells =
+            _mm256_i32gather_epi32(row.next32.data(), cells, 4);
+        __m256i fired_cells =
+            _mm256_i32gather_epi32(row.fired32.data(), cells, 4);
+        if constexpr (Masked) {
+          const auto sel = static_cast<int>(bits(*selected, i, 8));
+          const __m256i mask = _mm256_cmpeq_epi32(
+              _mm256_and_si256(_mm256_set1_epi32(sel), select), select);
+          next_cells = _mm256_blendv_epi8(cells, next_cells, mask);
+          fired_cells = _mm256_and_si256(fired_cells, mask);
+        }
+        next_cells = _mm256_permutevar8x32_epi32(
+            _mm256_shuffle_epi8(next_cells, low_bytes), join);
+        _mm_storel_epi64(ptr, _mm256_castsi256_si128(next_cells));
+        const auto f = static_cast<std::uint32_t>(
+            _mm256_movemask_ps(_mm256_castsi256_ps(fired_cells)));
+        count += static_cast<std::size_t>(__builtin_popcount(f));
+        put_bits(fired, i, f);
+      }
+      return count;
+    }
+#elif defined(__SSSE3__)
+    template <class Event, bool Masked>
+    inline std::size_t shuffle(std::size_t& i, const mask_t* selected,
+                               mask_t* fired) noexcept {
+      constexpr auto& row = event_row<Event>::value;
+      const __m128i next =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(row.next.data()));
+      const __m128i fire =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(row.fired.data()));
+      const __m128i spread =
+          _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1);
+      const __m128i select =
+          _mm_set1_epi64x(static_cast<long long>(0x8040201008040201ull));
+
+      std::size_t count = 0;
+      for (; i + 16 <= Capacity; i += 16) {
+        auto* ptr = reinterpret_cast<__m128i*>(m_cells.data() + i);
+        const __m128i cells = _mm_load_si128(ptr);
+        __m128i next_cells = _mm_shuffle_epi8(next, cells);
+        __m128i fired_cells = _mm_shuffle_epi8(fire, cells);
+        if constexpr (Masked) {
+          const auto sel = static_cast<short>(bits(*selected, i, 16));
+          __m128i mask = _mm_shuffle_epi8(_mm_set1_epi16(sel), spread);
+          mask = _mm_cmpeq_epi8(_mm_and_si128(mask, select), select);
+          next_cells = _mm_or_si128(_mm_and_si128(mask, next_cells),
+                                    _mm_andnot_si128(mask, cells));
+          fired_cells = _mm_and_si128(fired_cells, mask);
+        }
+        _mm_store_si128(ptr, next_cells);
+        const auto f =
+            static_cast<std::uint32_t>(_mm_movemask_epi8(fired_cells));
+        count += static_cast<std::size_t>(__builtin_popcount(f));
+        put_bits(fired, i, f);
+      }
+      return count;
+    }
+#endif
+
+    template <class Event, bool Masked>
+    std::size_t apply(const mask_t* selected, mask_t* fired) noexcept {
+      if (fired) fired->reset();
+      if constexpr (!table::template has_event<Event>) {
+        return 0;
+      } else {
+        std::size_t i = 0;
+        std::size_t count = 0;
+#if defined(__SSSE3__) || defined(__AVX2__)
+        if constexpr (byte_cells && cell_count <= 16)
+          count += shuffle<Event, Masked>(i, selected, fired);
+#endif
+#if defined(__AVX2__)
+        if constexpr (byte_cells && cell_count > 16)
+          count += gather<Event, Masked>(i, selected, fired);
+#endif
+        return count + scalar<Event, Masked>(i, selected, fired);
+      }
+    }
+
+  public:
+    /**
+     * @brief Constructs the pool, where every machine is in the initial state
+     */
+    inline state_machine_pool() noexcept {
+      m_cells.fill(static_cast<cell_t>(table::template guard_index<none>));
+    }
+
+    static constexpr std::size_t size() noexcept { return Capacity; }
+
+    /**
+     * @brief Pass an event to all machines of the pool
+     *
+     * @tparam Event event
+     * @param fired optional mask, where the machines, which performed a
+     * transition, are set
+     *
+     * @return the number of machines, which performed a transition
+     */
+    template <class Event>
+    inline std::size_t event(mask_t* fired = nullptr) noexcept {
+      return apply<Event, false>(nullptr, fired);
+    }
+
+    /**
+     * @brief Pass an event to the selected machines of the pool
+     *
+     * @tparam Event event
+     * @param selected mask of machines, which receive the event
+     * @param fired optional mask, where the machines, which performed a
+     * transition, are set
+     *
+     * @return the number of machines, which performed a transition
+     */
+    template <class Event>
+    inline std::size_t event(const mask_t& selected,
+                             mask_t* fired = nullptr) noexcept {
+      return apply<Event, true>(&selected, fired);
+    }
+
+    /**
+     * @brief Change the current guard of the machine
+     *
+     * @tparam Guard next guard
+     * @param idx index of the machine
+     */
+    template <class Guard>
+    inline void guard(std::size_t idx) noexcept {
+      if constexpr (__details::static_check_contains<
+                        Guard, typename Table::guard_collection>()) {
+        const std::size_t cell = m_cells[idx];
+        m_cells[idx] = static_cast<cell_t>(
+            cell - cell % guard_count + table::template guard_index<Guard>);
+      }
+    }
+
+    /**
+     * @brief Change the current guard of all machines
+     *
+     * @tparam Guard next guard
+     */
+    template <class Guard>
+    inline void guard() noexcept {
+      for (std::size_t idx = 0; idx < Capacity; ++idx) guard<Guard>(idx);
+    }
+
+    /**
+     * @brief Index of the current state of the machine in the state
+     * collection of the table
+     */
+    inline std::size_t state(std::size_t idx) const noexcept {
+      return m_cells[idx] / guard_count;
+    }
+
+    /**
+     * @brief Checks, if the machine is in the state State
+     */
+    template <class State>
+    inline bool is_in(std::size_t idx) const noexcept {
+      return state(idx) == table::template state_index<State>;
+    }
+  };
+
+} // namespace pure
+
+#endif
@@ -0,0 +1,139 @@
+/**
+ * @file queue.hpp
+ *
+ * File that contains lock-free queues, that are shared by the multi-threaded
+ * machines and loggers.
+ */
+#ifndef PUREFSM_QUEUE_HPP
+#define PUREFSM_QUEUE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace pure {
+
+  namespace __details {
+
+    /*
+     * Bounded single-producer single-consumer queue. The consumer side may
+     * be taken over by another thread, if the handover is synchronized.
+     */
+    template <class T, std::size_t Capacity>
+    class spsc_queue {
+    private:
+      static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                    "Queue capacity must be a power of two");
+
+      static constexpr std::size_t mask = Capacity - 1;
+
+      alignas(64) std::atomic<std::size_t> m_head {0};
+      alignas(64) std::atomic<std::size_t> m_tail {0};
+      alignas(64) std::array<T, Capacity> m_values;
+
+    public:
+      inline bool push(const T& value) noexcept {
+        const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == Capacity)
+          return false;
+        m_values[tail & mask] = value;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+      }
+
+      inline bool pop(T& value) noexcept {
+        const std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) return false;
+        value = m_values[head & mask];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+      }
+
+      /*
+       * Approximate number of values in the queue; may be called by any
+       * thread.
+       */
+      inline std::size_t size() const noexcept {
+        const std::size_t head = m_head.load(std::memory_order_acquire);
+        return m_tail.load(std::memory_order_acquire) - head;
+      }
+    };
+
+    /*
+     * Bounded multi-producer single-consumer queue. Every slot has a
+     * sequence number, which tells producers and the consumer, whose turn it
+     * is to use the slot, so the queue needs neither locks nor allocation.
+     */
+    template <class T, std::size_t Capacity>
+    class mpsc_queue {
+    private:
+      static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                    "Queue capacity must be a power of two");
+
+      static constexpr std::size_t mask = Capacity - 1;
+
+      struct slot {
+        std::atomic<std::size_t> seq;
+        T value;
+      };
+
+      alignas(64) std::array<slot, Capacity> m_slots;
+      alignas(64) std::atomic<std::size_t> m_tail {0};
+      alignas(64) std::size_t m_head = 0;
+
+    public:
+      inline mpsc_queue() noexcept {
+        for (std::size_t i = 0; i < Capacity; ++i)
+          m_slots[i].seq.store(i, std::memory_order_relaxed);
+      }
+
+      /*
+       * Called by producers; returns false, if the queue is full.
+       */
+      inline bool push(const T& value) noexcept {
+        std::size_t pos = m_tail.load(std::memory_order_relaxed);
+        for (;;) {
+          slot& s = m_slots[pos & mask];
+          const std::size_t seq = s.seq.load(std::memory_order_acquire);
+          const auto diff = static_cast<std::ptrdiff_t>(seq - pos);
+          if (diff == 0) {
+            if (m_tail.compare_exchange_weak(pos, pos + 1,
+                                             std::memory_order_relaxed))
+              break;
+          } else if (diff < 0)
+            return false;
+          else
+            pos = m_tail.load(std::memory_order_relaxed);
+        }
+        slot& s = m_slots[pos & mask];
+        s.value = value;
+        s.seq.store(pos + 1, std::memory_order_release);
+        return true;
+      }
+
+      /*
+       * Called by the consumer only; returns false, if the queue is empty.
+       */
+      inline bool pop(T& value) noexcept {
+        slot& s = m_slots[m_head & mask];
+        if (s.seq.load(std::memory_order_acquire) != m_head + 1) return false;
+        value = s.value;
+        s.seq.store(m_head + Capacity, std::memory_order_release);
+        ++m_head;
+        return true;
+      }
+
+      /*
+       * Called by the consumer only.
+       */
+      inline bool empty() const noexcept {
+        const slot& s = m_slots[m_head & mask];
+        return s.seq.load(std::memory_order_acquire) != m_head + 1;
+      }
+    };
+
+  } // namespace __details
+
+} // namespace pure
+
+#endif
@@ -0,0 +1,350 @@
+/**
+ * @file ring_logger.hpp
+ *
+ * File that contains an asynchronous logger, that keeps binary records in
+ * per-thread ring buffers and formats them on a background thread.
+ */
+#ifndef PUREFSM_RING_LOGGER_HPP
+#define PUREFSM_RING_LOGGER_HPP
+
+#include "logger.hpp"
+#include "queue.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+  #include <x86intrin.h>
+#endif
+
+namespace pure {
+
+  namespace __details {
+
+    /*
+     * Binary record of a log message. The message is a pointer to the
+     * string literal, passed to the logger, and the type is a pointer to the
+     * function, that returns the type name, so nothing is formatted or
+     * copied, until the record is written out.
+     */
+    struct log_record {
+      std::uint64_t time;
+      std::uint32_t machine;
+      const char* message;
+      std::string_view (*type)() noexcept;
+    };
+
+    /*
+     * Timestamp of a record: the time stamp counter, where it is available,
+     * as it is several times cheaper to read than the steady clock. Ticks
+     * are converted to nanoseconds only when records are formatted.
+     */
+    inline std::uint64_t log_ticks() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+      return __rdtsc();
+#else
+      return static_cast<std::uint64_t>(
+          std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+  } // namespace __details
+
+  /**
+   * @brief Destination of ring_logger records
+   *
+   * The sink owns one ring buffer of `ring_capacity` records per thread,
+   * that logs into it, and a background thread, that takes the records from
+   * all rings every `flush_interval`, sorts them by time, formats them and
+   * writes them to the stream in one batch. A record is formatted as
+   *
+   * ```
+   * <time, ns since the sink start> #<machine id> <message><type name>
+   * ```
+   *
+   * Logging never blocks and never allocates, except for the ring, that is
+   * allocated by the first record of a thread. A thread releases its ring,
+   * when it exits, and the ring is reused by another thread, once its
+   * records are written out. If the ring of a thread is full, or more than
+   * `max_threads` threads log into the sink at once, records are dropped and
+   * counted by `dropped`.
+   */
+  class ring_log_sink {
+  public:
+    /** @brief Number of records in the ring of one thread */
+    static constexpr std::size_t ring_capacity = 4096;
+
+    /** @brief Maximal number of threads, that log into the sink at once */
+    static constexpr std::size_t max_threads = 64;
+
+    /** @brief Period, with which the background thread takes records */
+    static constexpr std::chrono::microseconds flush_interval {1000};
+
+  private:
+    using clock = std::chrono::steady_clock;
+    using record = __details::log_record;
+
+    /*
+     * Ring of one thread. The thread sets released, when it exits or drops
+     * the ring from its cache, and pushes nothing after that. The ring is
+     * shared with the caches of the threads, so it outlives the sink, if a
+     * thread exits after the sink is destroyed.
+     */
+    struct ring {
+      std::atomic<bool> released {false};
+      __details::spsc_queue<record, ring_capacity> queue;
+    };
+
+    /* Sinks are told apart by their ids in the thread-local ring caches */
+    static inline std::atomic<std::uint64_t> s_next_id {1};
+
+    std::ostream& m_stream;
+    const std::uint64_t m_id;
+    const clock::time_point m_start;
+    const std::uint64_t m_start_ticks;
+    double m_ns_per_tick = 1;
+    std::array<std::shared_ptr<ring>, max_threads> m_rings;
+    std::atomic<std::size_t> m_ring_count {0};
+    std::mutex m_register;
+    std::atomic<std::size_t> m_dropped {0};
+    std::atomic<bool> m_stop {false};
+    std::vector<record> m_batch;
+    std::string m_text;
+    std::thread m_thread;
+
+    /*
+     * Returns a ring for the calling thread: a released ring, whose records
+     * are written out, or a new one; nullptr, if there are too many threads.
+     * Called once per thread and sink, the result is cached.
+     */
+    std::shared_ptr<ring> register_thread() {
+      std::lock_guard<std::mutex> lock(m_register);
+      const std::size_t count = m_ring_count.load(std::memory_order_relaxed);
+      for (std::size_t idx = 0; idx < count; ++idx) {
+        ring& free = *m_rings[idx];
+        if (free.released.load(std::memory_order_acquire) &&
+            free.queue.size() == 0) {
+          free.released.store(false, std::memory_order_relaxed);
+          return m_rings[idx];
+        }
+      }
+      if (count == max_threads) return nullptr;
+
+      m_rings[count] = std::make_shared<ring>();
+      m_ring_count.store(count + 1, std::memory_order_release);
+      return m_rings[count];
+    }
+
+    /*
+     * Rings of the calling thread in the last sinks it logged into; a ring
+     * is released, when it is dropped from the cache or the thread exits.
+     */
+    struct ring_cache {
+      struct entry {
+        std::uint64_t sink = 0;
+        std::shared_ptr<ring> local;
+
+        void release() noexcept {
+          if (local) local->released.store(true, std::memory_order_release);
+        }
+      };
+
+      std::array<entry, 4> entries;
+      std::size_t victim = 0;
+
+      ~ring_cache() {
+        for (entry& e : entries) e.release();
+      }
+    };
+
+    inline ring* local_ring() {
+      thread_local ring_cache cache;
+
+      for (const auto& e : cache.entries)
+        if (e.sink == m_id) return e.local.get();
+      auto& e = cache.entries[cache.victim++ % cache.entries.size()];
+      e.release();
+      e = {m_id, register_thread()};
+      return e.local.get();
+    }
+
+    void format(const record& rec) {
+      char prefix[64];
+      const std::uint64_t ticks =
+          rec.time > m_start_ticks ? rec.time - m_start_ticks : 0;
+      const int size = std::snprintf(
+          prefix, sizeof(prefix), "%llu #%lu ",
+          static_cast<unsigned long long>(ticks * m_ns_per_tick),
+          static_cast<unsigned long>(rec.machine));
+      m_text.append(prefix, static_cast<std::size_t>(size));
+      m_text.append(rec.message);
+      if (rec.type) m_text.append(rec.type());
+      m_text.push_back('\n');
+    }
+
+    /*
+     * Takes all records from the rings and writes them out; returns their
+     * number.
+     */
+    std::size_t drain() {
+      const std::size_t count = m_ring_count.load(std::memory_order_acquire);
+      record rec;
+      for (std::size_t idx = 0; idx < count; ++idx)
+        while (m_rings[idx]->queue.pop(rec)) m_batch.push_back(rec);
+      if (m_batch.empty()) return 0;
+
+      // Ticks are calibrated against the steady clock over the whole
+      // lifetime of the sink.
+      const auto now = clock::now();
+      const std::uint64_t ticks = __details::log_ticks();
+      if (ticks > m_start_ticks)
+        m_ns_per_tick =
+            std::chrono::duration<double, std::nano>(now - m_start).count() /
+            static_cast<double>(ticks - m_start_ticks);
+
+      std::stable_sort(m_batch.begin(), m_batch.end(),
+                       [](const record& lhs, const record& rhs) {
+                         return lhs.time < rhs.time;
+                       });
+      for (const record& r : m_batch) format(r);
+      m_stream.write(m_text.data(),
+                     static_cast<std::streamsize>(m_text.size()));
+      m_stream.flush();
+
+      const std::size_t written = m_batch.size();
+      m_batch.clear();
+      m_text.clear();
+      return written;
+    }
+
+    void run() {
+      for (;;) {
+        const bool stop = m_stop.load(std::memory_order_acquire);
+        if (drain()) continue;
+        if (stop) return;
+        std::this_thread::sleep_for(flush_interval);
+      }
+    }
+
+  public:
+    /**
+     * @brief Constructs the sink, that writes to the stream, and starts its
+     * background thread
+     */
+    explicit ring_log_sink(std::ostream& stream)
+        : m_stream(stream), m_id(s_next_id.fetch_add(1)),
+          m_start(clock::now()), m_start_ticks(__details::log_ticks()) {
+      m_batch.reserve(ring_capacity);
+      m_thread = std::thread([this] { run(); });
+    }
+
+    ring_log_sink(const ring_log_sink&) = delete;
+    ring_log_sink& operator=(const ring_log_sink&) = delete;
+
+    inline ~ring_log_sink() { stop(); }
+
+    /**
+     * @brief Appends a record to the ring of the calling thread
+     *
+     * @param machine id of the machine, that logs
+     * @param message string literal
+     * @param type function, that returns the name of the logged type, or
+     * nullptr
+     *
+     * @return false, if the record was dropped
+     */
+    inline bool push(std::uint32_t machine, const char* message,
+                     std::string_view (*type)() noexcept) {
+      ring* local = local_ring();
+      if (local && local->queue.push(record {__details::log_ticks(), machine,
+                                             message, type}))
+        return true;
+      m_dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    /**
+     * @brief Writes out the records, that are already logged, and stops the
+     * background thread
+     *
+     * Nothing must be logged into the sink after the call.
+     */
+    void stop() {
+      if (!m_thread.joinable()) return;
+      m_stop.store(true, std::memory_order_release);
+      m_thread.join();
+    }
+
+    /**
+     * @brief Approximate number of records, that are not written out yet
+     */
+    std::size_t pending() const noexcept {
+      const std::size_t count = m_ring_count.load(std::memory_order_acquire);
+      std::size_t size = 0;
+      for (std::size_t idx = 0; idx < count; ++idx)
+        size += m_rings[idx]->queue.size();
+      return size;
+    }
+
+    /**
+     * @brief Number of dropped records
+     */
+    std::size_t dropped() const noexcept {
+      return m_dropped.load(std::memory_order_relaxed);
+    }
+  };
+
+  /**
+   * @brief Asynchronous State Machine logger
+   *
+   * The logger writes fixed-size binary records into a ring_log_sink: the
+   * time, the id of the machine, the message and the logged type. Names of
+   * types are resolved and records are formatted only by the background
+   * thread of the sink, so logging costs a clock read and a store into a
+   * thread-local ring.
+   *
+   * The logger is a reference to the sink, so many machines may share one
+   * sink and tell their records apart by their machine ids.
+   *
+   * See @ref fsm_logger
+   */
+  class ring_logger {
+  private:
+    ring_log_sink* m_sink;
+    std::uint32_t m_machine;
+
+  public:
+    /**
+     * @brief Constructs the logger, that writes into the sink
+     *
+     * @param sink destination of the records
+     * @param machine id of the machine, that is written in every record
+     */
+    inline ring_logger(ring_log_sink& sink, std::uint32_t machine = 0) noexcept
+        : m_sink(&sink), m_machine(machine) {}
+
+    template <typename T>
+    inline void write(const char* str) {
+      m_sink->push(m_machine, str, &logger::type_name<T>);
+    }
+
+    inline void write(const char* str) {
+      m_sink->push(m_machine, str, nullptr);
+    }
+  };
+
+} // namespace pure
+
+#endif
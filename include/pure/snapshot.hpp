@@ -0,0 +1,129 @@
+/**
+ * @file snapshot.hpp
+ *
+ * File that contains saving and restoring of the states and guards of arrays
+ * of State Machines to and from contiguous byte buffers.
+ */
+#ifndef PUREFSM_SNAPSHOT_HPP
+#define PUREFSM_SNAPSHOT_HPP
+
+#include "fsm.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace pure {
+
+  namespace __details {
+
+    /*
+     * A buffer starts with the fingerprint of the table and the number of
+     * machines, 8 bytes each.
+     */
+    inline constexpr std::size_t snapshot_header_size = 16;
+
+    /*
+     * Bytes of the cell of one machine: the width of the smallest unsigned
+     * type, that holds every cell of the table.
+     */
+    template <class Table>
+    inline constexpr std::size_t snapshot_cell_size =
+        sizeof(least_uint_t<compiled_table<Table>::cell_count - 1>);
+
+    template <std::size_t Bytes>
+    inline void store_le(std::byte* out, std::uint64_t value) noexcept {
+      for (std::size_t idx = 0; idx < Bytes; ++idx)
+        out[idx] = static_cast<std::byte>(value >> (8 * idx));
+    }
+
+    template <std::size_t Bytes>
+    inline std::uint64_t load_le(const std::byte* in) noexcept {
+      std::uint64_t value = 0;
+      for (std::size_t idx = 0; idx < Bytes; ++idx)
+        value |= std::uint64_t(std::to_integer<unsigned char>(in[idx]))
+                 << (8 * idx);
+      return value;
+    }
+
+  } // namespace __details
+
+  /**
+   * @brief Size in bytes of the snapshot of count machines with the table
+   * Table
+   */
+  template <class Table>
+  constexpr std::size_t snapshot_size(std::size_t count) noexcept {
+    return __details::snapshot_header_size +
+           count * __details::snapshot_cell_size<Table>;
+  }
+
+  /**
+   * @brief Save the states and the guards of the machines into the buffer
+   *
+   * @param machines array of count machines
+   * @param buffer at least `snapshot_size<Table>(count)` bytes
+   *
+   * @return the number of written bytes, `snapshot_size<Table>(count)`
+   *
+   * The buffer holds the fingerprint of the table, the number of machines,
+   * and then the cell of every machine (see `machine_snapshot`) in the
+   * smallest number of bytes, that fits any cell of the table, usually one.
+   * All integers are little-endian, so the buffer may be restored on another
+   * platform by a build of the same compiler.
+   */
+  template <class Table, class Logger, class Metrics, class Queue>
+  std::size_t
+  save_snapshots(const state_machine<Table, Logger, Metrics, Queue>* machines,
+                 std::size_t count, std::byte* buffer) noexcept {
+    using table = __details::compiled_table<Table>;
+    constexpr std::size_t cell_size = __details::snapshot_cell_size<Table>;
+
+    __details::store_le<8>(buffer, table::fingerprint);
+    __details::store_le<8>(buffer + 8, count);
+    std::byte* out = buffer + __details::snapshot_header_size;
+    for (std::size_t idx = 0; idx < count; ++idx, out += cell_size)
+      __details::store_le<cell_size>(out, machines[idx].snapshot().cell);
+    return snapshot_size<Table>(count);
+  }
+
+  /**
+   * @brief Restore the states and the guards of the machines, saved by
+   * `save_snapshots`
+   *
+   * @param machines array of count machines
+   * @param buffer snapshot of size bytes
+   *
+   * @return false, and no machine is changed, if the buffer was saved from
+   * machines with another table, from another number of machines, or is
+   * damaged
+   */
+  template <class Table, class Logger, class Metrics, class Queue>
+  bool
+  restore_snapshots(state_machine<Table, Logger, Metrics, Queue>* machines,
+                    std::size_t count, const std::byte* buffer,
+                    std::size_t size) noexcept {
+    using table = __details::compiled_table<Table>;
+    constexpr std::size_t cell_size = __details::snapshot_cell_size<Table>;
+
+    if (size != snapshot_size<Table>(count) ||
+        __details::load_le<8>(buffer) != table::fingerprint ||
+        __details::load_le<8>(buffer + 8) != count)
+      return false;
+
+    const std::byte* cells = buffer + __details::snapshot_header_size;
+    for (std::size_t idx = 0; idx < count; ++idx)
+      if (__details::load_le<cell_size>(cells + idx * cell_size) >=
+          table::cell_count)
+        return false;
+
+    for (std::size_t idx = 0; idx < count; ++idx) {
+      const auto cell = static_cast<std::uint32_t>(
+          __details::load_le<cell_size>(cells + idx * cell_size));
+      machines[idx].restore({table::fingerprint, cell});
+    }
+    return true;
+  }
+
+} // namespace pure
+
+#endif
@@ -0,0 +1,476 @@
+/**
+ * @file timed.hpp
+ *
+ * File that contains timed transitions and a set of State Machines, whose
+ * timeouts are kept in a hierarchical timing wheel.
+ */
+#ifndef PUREFSM_TIMED_HPP
+#define PUREFSM_TIMED_HPP
+
+#include "fsm.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ratio>
+#include <utility>
+#include <vector>
+
+namespace pure {
+
+  /**
+   * @brief Event, that is passed to a machine, which stays in the source
+   * state of the transition for the given time
+   *
+   * @tparam Count number of periods
+   * @tparam Period period, milliseconds by default
+   *
+   * ```cpp
+   * tr<Waiting, pure::after<500>, Idle, none, none>
+   * ```
+   *
+   * The event is passed by `timed_machines`; for other machines it is a
+   * plain event.
+   */
+  template <std::intmax_t Count, class Period = std::milli>
+  struct after {
+    static_assert(Count >= 0, "Timeout must not be negative");
+
+    /** @cond undocumented */
+    using duration = std::chrono::duration<std::intmax_t, Period>;
+    static constexpr duration value {Count};
+    /** @endcond */
+  };
+
+  namespace __details {
+
+    template <class Event>
+    struct timeout_of {
+      template <class Tick>
+      static constexpr std::uint64_t ticks = 0;
+    };
+
+    /*
+     * Timeouts are rounded up to whole ticks, and last at least one tick,
+     * so a timed event is never passed in the tick it was armed.
+     */
+    template <std::intmax_t Count, class Period>
+    struct timeout_of<after<Count, Period>> {
+      template <class Tick>
+      static constexpr std::uint64_t ticks = [] {
+        const auto count =
+            std::chrono::ceil<Tick>(after<Count, Period>::value).count();
+        return count < 1 ? std::uint64_t(1) : std::uint64_t(count);
+      }();
+    };
+
+    /*
+     * timeout_cells holds, for every cell of the table, the timed event,
+     * which is armed in that cell, and its timeout in ticks. Of all timed
+     * events, that have a transition in the cell, the shortest one is
+     * armed. A cell without timed events has the event `event_count`.
+     */
+    template <class Table, class Tick>
+    struct timeout_cells {
+      using table = compiled_table<Table>;
+
+      struct timeout {
+        std::uint32_t event;
+        std::uint64_t ticks;
+      };
+
+      template <typename... Es>
+      static constexpr std::array<std::uint64_t, sizeof...(Es)>
+      make_ticks(tp::type_pack<Es...>) noexcept {
+        return {timeout_of<Es>::template ticks<Tick>...};
+      }
+
+      static constexpr auto event_ticks =
+          make_ticks(typename Table::event_collection {});
+
+      static constexpr std::array<timeout, table::cell_count> make() noexcept {
+        std::array<timeout, table::cell_count> result {};
+        for (std::size_t cell = 0; cell < table::cell_count; ++cell) {
+          result[cell] = {static_cast<std::uint32_t>(table::event_count), 0};
+          for (std::size_t ev = 0; ev < table::event_count; ++ev) {
+            if (!event_ticks[ev] ||
+                table::lookup(ev, cell) == table::no_transition)
+              continue;
+            if (result[cell].ticks && result[cell].ticks <= event_ticks[ev])
+              continue;
+            result[cell] = {static_cast<std::uint32_t>(ev), event_ticks[ev]};
+          }
+        }
+        return result;
+      }
+
+      static constexpr auto value = make();
+
+      static constexpr bool any = [] {
+        for (auto ticks : event_ticks)
+          if (ticks) return true;
+        return false;
+      }();
+    };
+
+    /*
+     * Hierarchical timing wheel of one timer per id: four levels of 64
+     * slots, the level L holds the timers, that expire within 64^(L+1)
+     * ticks. Timers are nodes of intrusive doubly linked lists, indexed by
+     * their ids, so arming and canceling are O(1) and do not allocate. A
+     * slot of an upper level is cascaded into the lower levels, when the
+     * time reaches it. Timers beyond the wheel span are placed at its end
+     * and are placed again, when they are reached.
+     */
+    class timer_wheel {
+    public:
+      static constexpr std::uint32_t nil = UINT32_MAX;
+
+    private:
+      static constexpr unsigned bits = 6;
+      static constexpr std::size_t slot_count = std::size_t(1) << bits;
+      static constexpr std::size_t slot_mask = slot_count - 1;
+      static constexpr unsigned levels = 4;
+      static constexpr std::uint64_t span = std::uint64_t(1)
+                                            << (bits * levels);
+
+      struct node {
+        std::uint32_t next = nil;
+        std::uint32_t prev = nil;
+        std::uint32_t slot = nil;
+        std::uint64_t expires = 0;
+      };
+
+      std::vector<node> m_nodes;
+      std::array<std::uint32_t, slot_count * levels> m_heads;
+      std::array<std::uint64_t, levels> m_occupied {};
+      std::uint64_t m_now = 0;
+      std::size_t m_armed = 0;
+      std::vector<std::uint32_t> m_batch;
+
+      inline void link(std::uint32_t id, std::uint32_t slot) noexcept {
+        node& n = m_nodes[id];
+        n.slot = slot;
+        n.prev = nil;
+        n.next = m_heads[slot];
+        if (n.next != nil) m_nodes[n.next].prev = id;
+        m_heads[slot] = id;
+        m_occupied[slot >> bits] |= std::uint64_t(1) << (slot & slot_mask);
+      }
+
+      inline void unlink(std::uint32_t id) noexcept {
+        node& n = m_nodes[id];
+        if (n.prev != nil)
+          m_nodes[n.prev].next = n.next;
+        else
+          m_heads[n.slot] = n.next;
+        if (n.next != nil) m_nodes[n.next].prev = n.prev;
+        if (m_heads[n.slot] == nil)
+          m_occupied[n.slot >> bits] &=
+              ~(std::uint64_t(1) << (n.slot & slot_mask));
+        n.slot = nil;
+      }
+
+      inline void place(std::uint32_t id) noexcept {
+        std::uint64_t delta = m_nodes[id].expires - m_now;
+        if (delta >= span) delta = span - 1;
+        const std::uint64_t at = m_now + delta;
+        unsigned level = 0;
+        while (level + 1 < levels &&
+               delta >= std::uint64_t(1) << (bits * (level + 1)))
+          ++level;
+        const std::size_t slot = (at >> (bits * level)) & slot_mask;
+        link(id, static_cast<std::uint32_t>(level * slot_count + slot));
+      }
+
+      /*
+       * Detaches the list of the slot and returns its first node.
+       */
+      inline std::uint32_t take(std::size_t slot) noexcept {
+        const std::uint32_t first = m_heads[slot];
+        m_heads[slot] = nil;
+        m_occupied[slot >> bits] &= ~(std::uint64_t(1) << (slot & slot_mask));
+        return first;
+      }
+
+      void cascade(unsigned level) noexcept {
+        const std::size_t slot =
+            level * slot_count + ((m_now >> (bits * level)) & slot_mask);
+        for (std::uint32_t id = take(slot); id != nil;) {
+          const std::uint32_t next = m_nodes[id].next;
+          place(id);
+          id = next;
+        }
+      }
+
+    public:
+      inline explicit timer_wheel(std::size_t count) : m_nodes(count) {
+        m_heads.fill(nil);
+        m_batch.reserve(count < 1024 ? count : 1024);
+      }
+
+      inline std::uint64_t now() const noexcept { return m_now; }
+
+      inline bool armed(std::uint32_t id) const noexcept {
+        return m_nodes[id].slot != nil;
+      }
+
+      inline std::size_t size() const noexcept { return m_armed; }
+
+      inline void arm(std::uint32_t id, std::uint64_t ticks) noexcept {
+        if (armed(id))
+          unlink(id);
+        else
+          ++m_armed;
+        m_nodes[id].expires = m_now + ticks;
+        place(id);
+      }
+
+      inline void cancel(std::uint32_t id) noexcept {
+        if (!armed(id)) return;
+        unlink(id);
+        --m_armed;
+      }
+
+      /*
+       * Moves the time by ticks and calls expired(ids, count) once per tick
+       * with the batch of the timers, that expired in that tick, which are
+       * disarmed before the call. Ticks without timers in the lowest level
+       * are skipped up to the next cascade.
+       */
+      template <class Expired>
+      std::size_t advance(std::uint64_t ticks, Expired&& expired) {
+        const std::uint64_t target = m_now + ticks;
+        std::size_t fired = 0;
+        while (m_now < target) {
+          if (m_armed == 0) {
+            m_now = target;
+            break;
+          }
+          if (m_occupied[0] == 0) {
+            const std::uint64_t boundary = (m_now | slot_mask) + 1;
+            if (boundary > target) {
+              m_now = target;
+              break;
+            }
+            m_now = boundary - 1;
+          }
+          ++m_now;
+          for (unsigned level = 1; level < levels; ++level) {
+            if (m_now & ((std::uint64_t(1) << (bits * level)) - 1)) break;
+            cascade(level);
+          }
+
+          for (std::uint32_t id = take(m_now & slot_mask); id != nil;) {
+            const std::uint32_t next = m_nodes[id].next;
+            m_nodes[id].slot = nil;
+            if (m_nodes[id].expires > m_now)
+              place(id);
+            else {
+              --m_armed;
+              m_batch.push_back(id);
+            }
+            id = next;
+          }
+          if (!m_batch.empty()) {
+            fired += m_batch.size();
+            expired(m_batch.data(), m_batch.size());
+            m_batch.clear();
+          }
+        }
+        return fired;
+      }
+    };
+
+  } // namespace __details
+
+  /**
+   * @brief Set of State Machines with timed transitions
+   *
+   * @tparam Table transition_table, that may have `after` events
+   * @tparam Tick resolution of the time, a `std::chrono::duration`
+   *
+   * The set keeps the state and the guard of every machine as one integer,
+   * the cell `state * G + guard`, in a contiguous array, and one timer per
+   * machine in a hierarchical timing wheel, which is shared by all machines.
+   *
+   * When a machine enters a cell, that has transitions by `after` events,
+   * the timer of the machine is armed with the shortest of their timeouts,
+   * and it is canceled, when the machine leaves the cell. So an `after`
+   * event is passed to a machine, that performed no transition for its
+   * time. A transition into the same state arms the timer again; an event
+   * without a transition does not. Arming and canceling a timer take O(1)
+   * and do not allocate. If a predicate rejects an expired timed event, the
+   * timer stays disarmed until the machine enters another cell.
+   *
+   * Time is moved by `advance`. The timeouts, that expired in one tick, are
+   * passed to their machines as a batch, in the ticks order.
+   *
+   * A set is used by one thread at a time.
+   */
+  template <class Table, class Tick = std::chrono::milliseconds>
+  class timed_machines {
+  private:
+    using table = __details::compiled_table<Table>;
+    using timeouts = __details::timeout_cells<Table, Tick>;
+
+    static constexpr std::size_t guard_count = table::guard_count;
+
+    using cell_t = __details::least_uint_t<table::cell_count - 1>;
+
+    std::vector<cell_t> m_cells;
+    __details::timer_wheel m_wheel;
+
+    inline void arm(std::size_t idx) noexcept {
+      const auto& timeout = timeouts::value[m_cells[idx]];
+      const auto id = static_cast<std::uint32_t>(idx);
+      if (timeout.event == table::event_count)
+        m_wheel.cancel(id);
+      else
+        m_wheel.arm(id, timeout.ticks);
+    }
+
+    template <typename... Args>
+    bool perform(std::size_t idx, std::size_t event_id, Args&&... args) {
+      cell_t& cell = m_cells[idx];
+      const std::size_t guard = cell % guard_count;
+      const std::size_t tr = __details::check_predicates<Table>(
+          table::lookup(event_id, cell), guard, args...);
+      if (tr == table::no_transition) return false;
+      cell = static_cast<cell_t>(table::targets[tr] * guard_count + guard);
+      if constexpr (timeouts::any) arm(idx);
+      __details::action_thunks<Table, Args...>::value[tr](
+          std::forward<Args>(args)...);
+      return true;
+    }
+
+  public:
+    /**
+     * @brief Runtime index of the event Event, that is accepted by
+     * `dispatch`
+     */
+    template <class Event>
+    static constexpr std::size_t event_id = table::template event_index<Event>;
+
+    /**
+     * @brief Constructs count machines in the initial state and arms their
+     * timers
+     */
+    explicit timed_machines(std::size_t count)
+        : m_cells(count,
+                  static_cast<cell_t>(table::template guard_index<none>)),
+          m_wheel(count) {
+      if constexpr (timeouts::any)
+        for (std::size_t idx = 0; idx < count; ++idx) arm(idx);
+    }
+
+    inline std::size_t size() const noexcept { return m_cells.size(); }
+
+    /**
+     * @brief Current time in ticks since the construction
+     */
+    inline std::uint64_t now() const noexcept { return m_wheel.now(); }
+
+    /**
+     * @brief Number of armed timers
+     */
+    inline std::size_t armed() const noexcept { return m_wheel.size(); }
+
+    /**
+     * @brief Tells, if the timer of the machine idx is armed
+     */
+    inline bool armed(std::size_t idx) const noexcept {
+      return m_wheel.armed(static_cast<std::uint32_t>(idx));
+    }
+
+    /**
+     * @brief Pass an event to the machine idx
+     *
+     * @return true, if the event caused a transition
+     */
+    template <class Event, typename... Args>
+    inline bool event(std::size_t idx, Args&&... args) {
+      if constexpr (table::template has_event<Event>)
+        return perform(idx, event_id<Event>, std::forward<Args>(args)...);
+      else
+        return false;
+    }
+
+    /**
+     * @brief Pass an event to the machine idx by the index of the event
+     *
+     * @return true, if the event caused a transition; indices out of the
+     * event collection are ignored
+     */
+    template <typename... Args>
+    inline bool dispatch(std::size_t idx, std::size_t event_id,
+                         Args&&... args) {
+      if (event_id >= table::event_count) return false;
+      return perform(idx, event_id, std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Move the time forward and pass the expired timed events
+     *
+     * @param elapsed time, rounded down to whole ticks
+     * @param args arguments of the transition actions, passed as lvalues
+     *
+     * @return the number of expired timers
+     *
+     * Timers, that are armed by the transitions of expired events, expire
+     * in later ticks of the same call, if their time comes.
+     */
+    template <class Rep, class Period, typename... Args>
+    std::size_t advance(std::chrono::duration<Rep, Period> elapsed,
+                        Args&&... args) {
+      const auto ticks = std::chrono::floor<Tick>(elapsed).count();
+      if (ticks <= 0) return 0;
+      return m_wheel.advance(
+          static_cast<std::uint64_t>(ticks),
+          [&](const std::uint32_t* ids, std::size_t count) {
+            for (std::size_t idx = 0; idx < count; ++idx)
+              perform(ids[idx], timeouts::value[m_cells[ids[idx]]].event,
+                      args...);
+          });
+    }
+
+    /**
+     * @brief Change the current guard of the machine idx
+     *
+     * The timer is armed again only if the guard changes the timed event.
+     */
+    template <class Guard>
+    inline void guard(std::size_t idx) noexcept {
+      if constexpr (__details::static_check_contains<
+                        Guard, typename Table::guard_collection>()) {
+        const std::size_t cell = m_cells[idx];
+        m_cells[idx] = static_cast<cell_t>(
+            cell - cell % guard_count + table::template guard_index<Guard>);
+        if constexpr (timeouts::any)
+          if (timeouts::value[cell].event !=
+              timeouts::value[m_cells[idx]].event)
+            arm(idx);
+      }
+    }
+
+    /**
+     * @brief Index of the current state of the machine idx in the state
+     * collection of the table
+     */
+    inline std::size_t state(std::size_t idx) const noexcept {
+      return m_cells[idx] / guard_count;
+    }
+
+    /**
+     * @brief Checks, if the machine idx is in the state State
+     */
+    template <class State>
+    inline bool is_in(std::size_t idx) const noexcept {
+      return state(idx) == table::template state_index<State>;
+    }
+  };
+
+} // namespace pure
+
+#endif
@@ -0,0 +1,98 @@
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <pure/active.hpp>
+#include <pure/fsm.hpp>
+#include <thread>
+#include <vector>
+
+struct StateA {};
+
+struct StateB {};
+
+struct counters {
+  std::size_t forward = 0;
+  std::size_t backward = 0;
+};
+
+struct Forward {
+  void operator()(counters*& c) { ++c->forward; }
+};
+
+struct Backward {
+  void operator()(counters*& c) { ++c->backward; }
+};
+
+struct Toggle {};
+
+using pure::none;
+using pure::tr;
+
+using table =
+    pure::transition_table<tr<StateA, Toggle, StateB, Forward, none>,
+                           tr<StateB, Toggle, StateA, Backward, none>>;
+
+template <class WaitPolicy>
+void run_producers() {
+  constexpr std::size_t producers = 4;
+  constexpr std::size_t events = 10000;
+
+  counters c;
+  std::atomic<std::size_t> posted = 0;
+  {
+    pure::active_machine<table, 256, counters*, WaitPolicy> machine;
+
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < producers; ++t)
+      threads.emplace_back([&] {
+        for (std::size_t i = 0; i < events; ++i)
+          while (!machine.template post<Toggle>(&c)) std::this_thread::yield();
+        posted += events;
+      });
+    for (auto& thread : threads) thread.join();
+    machine.stop();
+  }
+
+  // Every posted event toggles the machine and runs to completion
+  REQUIRE(posted == producers * events);
+  REQUIRE(c.forward + c.backward == posted);
+  REQUIRE(c.forward == c.backward);
+}
+
+TEST_CASE("Active machine with busy-spin wait") {
+  run_producers<pure::spin_wait>();
+}
+
+TEST_CASE("Active machine with futex wait") {
+  run_producers<pure::futex_wait>();
+}
+
+TEST_CASE("Active machine processes posted events on stop") {
+  counters c;
+  pure::active_machine<table, 16, counters*, pure::futex_wait> machine;
+
+  REQUIRE(machine.post<Toggle>(&c));
+  REQUIRE(machine.post(machine.event_id<Toggle>, &c));
+  REQUIRE(machine.post<Toggle>(&c));
+  machine.stop();
+
+  REQUIRE(c.forward == 2);
+  REQUIRE(c.backward == 1);
+}
+
+TEST_CASE("Active machine accepts batches of events") {
+  using machine_t = pure::active_machine<table, 8>;
+  using compiled = pure::__details::compiled_table<table>;
+  machine_t machine;
+
+  // Posting stops at the event out of range
+  constexpr std::size_t toggle = machine_t::event_id<Toggle>;
+  const std::size_t events[] = {toggle, toggle, toggle, compiled::event_count,
+                                toggle};
+  REQUIRE(machine.post(std::begin(events), std::end(events)) == 3);
+  REQUIRE_FALSE(machine.post(compiled::event_count));
+  machine.stop();
+
+  REQUIRE(machine.machine().snapshot().cell / compiled::guard_count ==
+          compiled::state_index<StateB>);
+}
@@ -0,0 +1,82 @@
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <pure/atomic.hpp>
+#include <pure/fsm.hpp>
+#include <thread>
+#include <vector>
+
+struct StateA {};
+
+struct StateB {};
+
+struct StateC {};
+
+struct Step {
+  void operator()(std::atomic<std::size_t>& calls) {
+    calls.fetch_add(1, std::memory_order_relaxed);
+  }
+};
+
+struct Next {};
+
+struct Lock {};
+
+using pure::none;
+using pure::not_;
+using pure::tr;
+
+using table =
+    pure::transition_table<tr<StateA, Next, StateB, Step, none>,
+                           tr<StateB, Next, StateC, Step, none>,
+                           tr<StateC, Next, StateA, Step, not_<Lock>>>;
+
+TEST_CASE("Atomic state machine") {
+  pure::atomic_state_machine<table> machine;
+  std::atomic<std::size_t> calls = 0;
+
+  REQUIRE(machine.is_in<StateA>());
+
+  SECTION("Transitions and guards") {
+    machine.guard<Lock>();
+    REQUIRE(machine.event<Next>(calls));
+    REQUIRE(machine.event<Next>(calls));
+    REQUIRE_FALSE(machine.event<Next>(calls));
+    REQUIRE(machine.is_in<StateC>());
+
+    machine.guard<none>();
+    REQUIRE(machine.dispatch(machine.event_id<Next>, calls));
+    REQUIRE(machine.is_in<StateA>());
+    REQUIRE(calls == 3);
+  }
+
+  SECTION("Events from several threads") {
+    constexpr std::size_t threads = 8;
+    constexpr std::size_t events = 20000;
+
+    std::atomic<std::size_t> performed = 0;
+    std::vector<std::thread> workers;
+    for (std::size_t t = 0; t < threads; ++t)
+      workers.emplace_back([&] {
+        std::size_t local = 0;
+        for (std::size_t i = 0; i < events; ++i)
+          local += machine.event<Next>(calls);
+        performed += local;
+      });
+
+    std::thread guards([&] {
+      for (std::size_t i = 0; i < events; ++i) {
+        machine.guard<Lock>();
+        machine.guard<none>();
+      }
+    });
+
+    for (auto& worker : workers) worker.join();
+    guards.join();
+
+    // Every performed transition calls its action exactly once, and the
+    // ring of states is walked by the number of performed transitions.
+    REQUIRE(calls == performed);
+    REQUIRE(machine.state() == performed % 3);
+  }
+}
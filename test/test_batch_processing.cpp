@@ -0,0 +1,104 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <iostream>
+#include <pure/fsm.hpp>
+#include <pure/logger.hpp>
+#include <vector>
+
+enum class current_state { None, A, B, C };
+
+struct StateA {
+  void operator()(current_state& state) { state = current_state::A; }
+};
+
+struct StateB {
+  void operator()(current_state& state) { state = current_state::B; }
+};
+
+struct StateC {
+  void operator()(current_state& state) { state = current_state::C; }
+};
+
+struct ActionCA {
+  void operator()(int& calls) { ++calls; }
+};
+
+struct EventAB {};
+
+struct EventBC {};
+
+struct EventCA {};
+
+using pure::none;
+using pure::tr;
+
+using table =
+    pure::transition_table<tr<StateA, EventAB, StateB, none, none>,
+                           tr<StateB, EventBC, StateC, none, none>,
+                           tr<StateC, EventCA, StateA, ActionCA, none>>;
+
+TEST_CASE("Batch processing without a logger") {
+  current_state state = current_state::None;
+  int calls = 0;
+
+  using machine_t = pure::state_machine<table>;
+  machine_t machine;
+
+  constexpr auto ab = machine_t::event_id<EventAB>;
+  constexpr auto bc = machine_t::event_id<EventBC>;
+  constexpr auto ca = machine_t::event_id<EventCA>;
+
+  SECTION("Transitions are counted") {
+    std::vector<std::uint8_t> events = {ab, bc, ab, ca, ab};
+    REQUIRE(machine.process(events, calls) == 4);
+    machine.action(state);
+
+    REQUIRE(state == current_state::B);
+    REQUIRE(calls == 1);
+  }
+
+  SECTION("State is written back without actions") {
+    const std::size_t events[] = {ab, bc};
+    REQUIRE(machine.process(std::begin(events), std::end(events), calls) == 2);
+    machine.action(state);
+
+    REQUIRE(state == current_state::C);
+    REQUIRE(calls == 0);
+  }
+
+  SECTION("Unknown events are skipped") {
+    const std::size_t events[] = {ca, 42, ab};
+    REQUIRE(machine.process(events) == 1);
+    machine.action(state);
+
+    REQUIRE(state == current_state::B);
+  }
+
+  SECTION("Batch of event variants") {
+    std::vector<table::event_v> events = {EventAB {}, EventBC {}, EventCA {}};
+    REQUIRE(machine.process(events.begin(), events.end(), calls) == 3);
+    machine.action(state);
+
+    REQUIRE(state == current_state::A);
+    REQUIRE(calls == 1);
+  }
+}
+
+TEST_CASE("Batch processing with a logger") {
+  current_state state = current_state::None;
+  int calls = 0;
+
+  using logger = pure::stdout_logger<std::cout>;
+  using machine_t = pure::state_machine<table, logger>;
+  machine_t machine;
+
+  const std::size_t events[] = {machine_t::event_id<EventAB>,
+                                machine_t::event_id<EventBC>,
+                                machine_t::event_id<EventCA>,
+                                machine_t::event_id<EventCA>};
+  REQUIRE(machine.process(events, calls) == 3);
+  machine.action(state);
+
+  REQUIRE(state == current_state::A);
+  REQUIRE(calls == 1);
+}
@@ -0,0 +1,97 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <iostream>
+#include <pure/fsm.hpp>
+#include <pure/logger.hpp>
+
+enum class current_state { None, A, B, C };
+
+struct StateA {
+  void operator()(current_state& state) { state = current_state::A; }
+};
+
+struct StateB {
+  void operator()(current_state& state) { state = current_state::B; }
+};
+
+struct StateC {
+  int payload = 0;
+
+  void operator()(current_state& state) { state = current_state::C; }
+};
+
+struct EventAB {};
+
+struct EventBA {};
+
+struct GuardA {};
+
+struct GuardB {};
+
+using pure::none;
+using pure::tr;
+
+using compact_table =
+    pure::transition_table<tr<StateA, EventAB, StateB, none, GuardA>,
+                           tr<StateB, EventBA, StateA, none, GuardB>>;
+
+using variant_table =
+    pure::transition_table<tr<StateA, EventAB, StateC, none, GuardA>,
+                           tr<StateC, EventBA, StateA, none, GuardB>>;
+
+TEST_CASE("Size of a state machine with empty states and guards") {
+  using logger = pure::stdout_logger<std::cout>;
+
+  STATIC_REQUIRE(sizeof(pure::state_machine<compact_table>) ==
+                 2 * sizeof(std::uint8_t));
+  STATIC_REQUIRE(sizeof(pure::state_machine<compact_table, logger>) ==
+                 2 * sizeof(std::uint8_t));
+  STATIC_REQUIRE(sizeof(pure::state_machine<variant_table>) >
+                 2 * sizeof(std::uint8_t));
+}
+
+TEST_CASE("State machine with compact storage") {
+  current_state state = current_state::None;
+
+  pure::state_machine<compact_table> machine;
+
+  machine.action(state);
+  REQUIRE(state == current_state::A);
+
+  SECTION("Guards are kept") {
+    machine.event<EventAB>();
+    machine.action(state);
+    REQUIRE(state == current_state::A);
+
+    machine.guard<GuardA>();
+    machine.event<EventAB>();
+    machine.action(state);
+    REQUIRE(state == current_state::B);
+
+    machine.guard<GuardB>();
+    machine.event<EventBA>();
+    machine.action(state);
+    REQUIRE(state == current_state::A);
+  }
+
+  SECTION("Batch processing") {
+    using machine_t = pure::state_machine<compact_table>;
+    const std::size_t events[] = {machine_t::event_id<EventAB>};
+
+    machine.guard<GuardA>();
+    REQUIRE(machine.process(events) == 1);
+    machine.action(state);
+    REQUIRE(state == current_state::B);
+  }
+}
+
+TEST_CASE("State machine with non-empty states") {
+  current_state state = current_state::None;
+
+  pure::state_machine<variant_table> machine;
+
+  machine.guard<GuardA>();
+  machine.event<EventAB>();
+  machine.action(state);
+  REQUIRE(state == current_state::C);
+}
@@ -0,0 +1,193 @@
+#include <catch2/catch_test_macros.hpp>
+#include <pure/fsm.hpp>
+#include <string>
+#include <type_traits>
+
+struct Idle {
+  void operator()(std::string& state) { state = "Idle"; }
+};
+
+struct Handshake {
+  void operator()(std::string& state) { state = "Handshake"; }
+};
+
+struct Ready {
+  void operator()(std::string& state) { state = "Ready"; }
+};
+
+struct Sending {
+  void operator()(std::string& state) { state = "Sending"; }
+};
+
+struct Flushing {
+  void operator()(std::string& state) { state = "Flushing"; }
+};
+
+struct Connect {};
+
+struct Accepted {};
+
+struct Send {};
+
+struct Sent {};
+
+struct Flush {};
+
+struct Drop {};
+
+struct Ping {};
+
+struct Secure {};
+
+struct CountDrop {
+  void operator()(int& drops) { ++drops; }
+};
+
+using pure::none;
+using pure::tr;
+
+using transfer_table =
+    pure::transition_table<tr<Sending, Sent, Flushing, none, none>,
+                           tr<Flushing, Flush, Sending, none, none>,
+                           tr<Sending, Ping, Sending, none, none>>;
+
+struct Transfer : pure::composite<transfer_table> {};
+
+using connected_table =
+    pure::transition_table<tr<Handshake, Accepted, Ready, none, none>,
+                           tr<Ready, Send, Transfer, none, none>,
+                           tr<Transfer, Flush, Ready, none, Secure>,
+                           tr<Ready, Ping, Ready, none, none>>;
+
+struct Connected : pure::composite<connected_table> {};
+
+using table =
+    pure::transition_table<tr<Idle, Connect, Connected, none, none>,
+                           tr<Connected, Drop, Idle, CountDrop, none>,
+                           tr<Connected, Ping, Idle, none, none>>;
+
+using machine_t = pure::state_machine<table>;
+
+TEST_CASE("Composite states are flattened into leaf states") {
+  using states = typename table::state_collection;
+
+  STATIC_REQUIRE_FALSE(tp::contains<Connected, states>::value);
+  STATIC_REQUIRE_FALSE(tp::contains<Transfer, states>::value);
+  STATIC_REQUIRE(tp::contains<Flushing, states>::value);
+  STATIC_REQUIRE(std::is_same_v<pure::__details::entry_t<Connected>,
+                                Handshake>);
+}
+
+TEST_CASE("Transitions of composite states are inherited") {
+  machine_t machine;
+  std::string state;
+  int drops = 0;
+
+  machine.event<Connect>(drops);
+  machine.action(state);
+  REQUIRE(state == "Handshake");
+
+  machine.event<Accepted>(drops);
+  machine.event<Send>(drops);
+  machine.action(state);
+  REQUIRE(state == "Sending");
+
+  machine.event<Sent>(drops);
+  machine.action(state);
+  REQUIRE(state == "Flushing");
+
+  SECTION("Leaf of a nested composite state leaves the outer one") {
+    machine.event<Drop>(drops);
+    machine.action(state);
+    REQUIRE(state == "Idle");
+    REQUIRE(drops == 1);
+  }
+
+  SECTION("Nested table overrides the inherited transition") {
+    machine.event<Flush>(drops);
+    machine.action(state);
+    REQUIRE(state == "Sending");
+
+    machine.event<Ping>(drops);
+    machine.action(state);
+    REQUIRE(state == "Sending");
+  }
+
+  SECTION("Inherited transition with a guard") {
+    machine.event<Flush>(drops);
+    machine.event<Flush>(drops);
+    machine.action(state);
+    REQUIRE(state == "Sending");
+
+    machine.guard<Secure>();
+    machine.event<Flush>(drops);
+    machine.action(state);
+    REQUIRE(state == "Ready");
+  }
+
+  SECTION("Ready overrides Ping of Connected, Handshake inherits it") {
+    machine_t other;
+    other.event<Connect>(drops);
+    other.event<Ping>(drops);
+    other.action(state);
+    REQUIRE(state == "Idle");
+  }
+}
+
+// The nested table starts in Ready instead of its first source. Composite
+// states of one table must not share leaf states, so Resumed is used by
+// another table than Connected.
+struct Resumed : pure::composite<connected_table, Ready> {};
+
+using resumed_table =
+    pure::transition_table<tr<Idle, Accepted, Resumed, none, none>,
+                           tr<Resumed, Drop, Idle, CountDrop, none>>;
+
+TEST_CASE("Composite state with an explicit initial state") {
+  STATIC_REQUIRE(std::is_same_v<pure::__details::entry_t<Resumed>, Ready>);
+
+  pure::state_machine<resumed_table> machine;
+  std::string state;
+  int drops = 0;
+
+  machine.event<Accepted>(drops);
+  machine.action(state);
+  REQUIRE(state == "Ready");
+
+  // Ping of Connected is not inherited by Resumed
+  machine.event<Ping>(drops);
+  machine.action(state);
+  REQUIRE(state == "Ready");
+
+  machine.event<Drop>(drops);
+  machine.action(state);
+  REQUIRE(state == "Idle");
+  REQUIRE(drops == 1);
+}
+
+// A state with data keeps the state machine in a variant
+struct Waiting {
+  int retries = 0;
+
+  void operator()(std::string& state) { state = "Waiting"; }
+};
+
+using waiting_table =
+    pure::transition_table<tr<Waiting, Connect, Connected, none, none>,
+                           tr<Connected, Drop, Waiting, none, none>>;
+
+TEST_CASE("Machine with state data starts in its first state") {
+  pure::state_machine<waiting_table> machine;
+  std::string state;
+
+  machine.action(state);
+  REQUIRE(state == "Waiting");
+
+  machine.event<Connect>();
+  machine.action(state);
+  REQUIRE(state == "Handshake");
+
+  machine.event<Drop>();
+  machine.action(state);
+  REQUIRE(state == "Waiting");
+}
@@ -0,0 +1,109 @@
+#include <catch2/catch_test_macros.hpp>
+#include <pure/fsm.hpp>
+#include <string>
+#include <vector>
+
+using log_t = std::vector<std::string>;
+
+struct Idle {};
+
+struct Running {};
+
+struct Stopping {};
+
+struct Stopped {};
+
+struct Start {};
+
+struct Stop {};
+
+struct Finish {};
+
+struct Reset {};
+
+/*
+ * Posts Stop and Finish: both run after the action returns.
+ */
+struct StartAction {
+  template <class Machine>
+  void operator()(Machine& machine, log_t& log) {
+    log.push_back("start");
+    log.push_back(machine.template post<Stop>() ? "posted" : "rejected");
+    log.push_back(machine.template post<Finish>() ? "posted" : "rejected");
+    log.push_back("started");
+  }
+};
+
+struct StopAction {
+  template <class Machine>
+  void operator()(Machine&, log_t& log) {
+    log.push_back("stop");
+  }
+};
+
+struct FinishAction {
+  template <class Machine>
+  void operator()(Machine&, log_t& log) {
+    log.push_back("finish");
+  }
+};
+
+using pure::none;
+using pure::tr;
+
+using table = pure::transition_table<
+    tr<Idle, Start, Running, StartAction, none>,
+    tr<Running, Stop, Stopping, StopAction, none>,
+    tr<Running, Finish, Stopped, FinishAction, none>,
+    tr<Stopping, Finish, Stopped, FinishAction, none>,
+    tr<Stopped, Reset, Idle, none, none>>;
+
+template <std::size_t Capacity,
+          pure::queue_overflow Overflow = pure::queue_overflow::reject>
+using machine_t = pure::state_machine<table, pure::empty_logger,
+                                      pure::empty_metrics,
+                                      pure::event_queue<Capacity, Overflow>>;
+
+TEST_CASE("Posted events run to completion after the current event") {
+  machine_t<4> machine;
+  log_t log;
+
+  machine.event<Start>(machine, log);
+  REQUIRE(log == log_t {"start", "posted", "posted", "started", "stop",
+                        "finish"});
+
+  SECTION("Posting outside of an event passes it at once") {
+    // Only Stopped accepts Reset, and only Idle accepts Start
+    REQUIRE(machine.post<Reset>());
+    log.clear();
+    REQUIRE(machine.dispatch(machine_t<4>::event_id<Start>, machine, log));
+    REQUIRE(log.back() == "finish");
+  }
+}
+
+TEST_CASE("Overflow of the internal event queue") {
+  log_t log;
+
+  SECTION("Reject") {
+    machine_t<1> machine;
+    machine.event<Start>(machine, log);
+    REQUIRE(log == log_t {"start", "posted", "rejected", "started", "stop"});
+  }
+
+  SECTION("Drop oldest") {
+    machine_t<1, pure::queue_overflow::drop_oldest> machine;
+    machine.event<Start>(machine, log);
+    REQUIRE(log == log_t {"start", "posted", "posted", "started", "finish"});
+  }
+}
+
+TEST_CASE("Batch processing drains the queue after every event") {
+  machine_t<2> machine;
+  log_t log;
+  const std::size_t events[] = {machine_t<2>::event_id<Start>,
+                                machine_t<2>::event_id<Reset>,
+                                machine_t<2>::event_id<Start>};
+
+  REQUIRE(machine.process(events, machine, log) == 3);
+  REQUIRE(log.size() == 12);
+}
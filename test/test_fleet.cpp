@@ -0,0 +1,72 @@
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <pure/fleet.hpp>
+#include <pure/fsm.hpp>
+#include <thread>
+#include <vector>
+
+struct StateA {};
+
+struct StateB {};
+
+struct Count {
+  void operator()(std::atomic<std::size_t>*& calls) { ++*calls; }
+};
+
+struct Toggle {};
+
+using pure::none;
+using pure::tr;
+
+using table = pure::transition_table<tr<StateA, Toggle, StateB, Count, none>,
+                                     tr<StateB, Toggle, StateA, Count, none>>;
+
+TEST_CASE("Fleet of keyed machines") {
+  constexpr std::size_t keys = 1000;
+  constexpr std::size_t producers = 2;
+  std::atomic<std::size_t> calls = 0;
+
+  using fleet_t =
+      pure::machine_fleet<table, std::size_t, std::atomic<std::size_t>*, 64>;
+  fleet_t fleet(3, producers);
+
+  // Producer p sends p + 2 toggles to every machine, so every machine gets
+  // an odd number of toggles in total.
+  std::vector<std::thread> threads;
+  for (std::size_t p = 0; p < producers; ++p)
+    threads.emplace_back([&, p] {
+      for (std::size_t round = 0; round < p + 2; ++round)
+        for (std::size_t key = 0; key < keys; ++key)
+          while (!fleet.post<Toggle>(p, key, &calls))
+            std::this_thread::yield();
+    });
+  for (auto& thread : threads) thread.join();
+  fleet.stop();
+
+  REQUIRE(fleet.size() == keys);
+  REQUIRE(fleet.transitions() == 5 * keys);
+  REQUIRE(calls == 5 * keys);
+  for (std::size_t key = 0; key < keys; ++key)
+    REQUIRE(fleet.is_in<StateB>(key));
+  REQUIRE_FALSE(fleet.is_in<StateB>(keys));
+}
+
+TEST_CASE("Fleet rejects invalid producers and events") {
+  std::atomic<std::size_t> calls = 0;
+
+  using fleet_t =
+      pure::machine_fleet<table, std::size_t, std::atomic<std::size_t>*, 64>;
+  fleet_t fleet(2, 1);
+
+  REQUIRE_FALSE(fleet.post(0, 1, 1, &calls));
+  REQUIRE_FALSE(fleet.post(0, 1, 1000, &calls));
+  REQUIRE_FALSE(fleet.post(1, 1, 0, &calls));
+  REQUIRE_FALSE(fleet.post<Toggle>(1, 1, &calls));
+  REQUIRE(fleet.post<Toggle>(0, 1, &calls));
+  fleet.stop();
+
+  REQUIRE(fleet.size() == 1);
+  REQUIRE(fleet.transitions() == 1);
+  REQUIRE(calls == 1);
+}
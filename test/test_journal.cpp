@@ -0,0 +1,216 @@
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <pure/fsm.hpp>
+#include <pure/journal.hpp>
+#include <signal.h>
+#include <string>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <vector>
+
+struct StateA {};
+
+struct StateB {};
+
+struct StateC {};
+
+struct EventAB {};
+
+struct EventBC {};
+
+struct EventCA {};
+
+std::atomic<long> total {0};
+
+struct Add {
+  void operator()(int& value) { total += value; }
+};
+
+using pure::none;
+using pure::tr;
+
+using table = pure::transition_table<tr<StateA, EventAB, StateB, Add, none>,
+                                     tr<StateB, EventBC, StateC, none, none>,
+                                     tr<StateC, EventCA, StateA, none, none>>;
+
+using other_table =
+    pure::transition_table<tr<StateA, EventAB, StateC, none, none>,
+                           tr<StateC, EventBC, StateB, none, none>>;
+
+using machine_t = pure::state_machine<table>;
+
+/*
+ * Path of a fresh file in the temporary directory, that is removed at the
+ * end of a test case.
+ */
+struct temp_file {
+  std::string path;
+
+  temp_file() {
+    const char* dir = std::getenv("TMPDIR");
+    path = std::string(dir ? dir : "/tmp") + "/purefsm_journal_" +
+           std::to_string(getpid()) + ".bin";
+    std::remove(path.c_str());
+  }
+
+  ~temp_file() { std::remove(path.c_str()); }
+};
+
+TEST_CASE("Replay of a journal restores the machines") {
+  temp_file file;
+  constexpr std::size_t count = 37;
+  constexpr std::size_t events = 3000;
+  std::vector<machine_t> machines(count);
+  long expected = 0;
+
+  // Every record is applied to the live machines and journaled, the
+  // journal is reopened halfway to check appending.
+  for (std::size_t half = 0; half < 2; ++half) {
+    pure::event_journal<table, int, 64> journal(file.path.c_str());
+    REQUIRE(journal.is_open());
+    for (std::size_t idx = half * events / 2; idx < (half + 1) * events / 2;
+         ++idx) {
+      const auto machine = static_cast<std::uint32_t>(idx * 7 % count);
+      const std::size_t event = idx % 3 == 2 ? 0 : idx % 3 + 1;
+      int payload = static_cast<int>(idx);
+      total = 0;
+      machines[machine].dispatch(event, payload);
+      expected += total;
+      REQUIRE(journal.append(machine, event, payload));
+    }
+    REQUIRE(journal.append<EventCA>(0, 1));
+    REQUIRE(journal.pending() > 0);
+    machines[0].event<EventCA>(1);
+  }
+
+  pure::journal_reader<table, int> reader(file.path.c_str());
+  REQUIRE(reader.is_open());
+  REQUIRE(reader.size() == events + 2);
+  REQUIRE(reader[0].machine == 0);
+  REQUIRE(reader[0].event == 1);
+
+  for (std::size_t threads : {1, 4}) {
+    std::vector<machine_t> replayed(count);
+    total = 0;
+    reader.replay(replayed.data(), replayed.size(), threads);
+    REQUIRE(total == expected);
+    for (std::size_t idx = 0; idx < count; ++idx)
+      REQUIRE(replayed[idx].snapshot().cell == machines[idx].snapshot().cell);
+  }
+}
+
+TEST_CASE("Journal of another table or payload is rejected") {
+  temp_file file;
+  {
+    pure::event_journal<table> journal(file.path.c_str());
+    REQUIRE(journal.append<EventAB>(0));
+  }
+
+  REQUIRE_FALSE(pure::event_journal<other_table>(file.path.c_str()).is_open());
+  REQUIRE_FALSE(
+      pure::journal_reader<table, int>(file.path.c_str()).is_open());
+
+  pure::journal_reader<table> reader(file.path.c_str());
+  REQUIRE(reader.is_open());
+  REQUIRE(reader.size() == 1);
+}
+
+TEST_CASE("Torn record at the end of a journal is cut off") {
+  temp_file file;
+  {
+    pure::event_journal<table> journal(file.path.c_str());
+    REQUIRE(journal.append<EventAB>(0));
+    REQUIRE(journal.append<EventBC>(0));
+  }
+  {
+    std::FILE* out = std::fopen(file.path.c_str(), "ab");
+    REQUIRE(out);
+    std::fputs("torn", out);
+    std::fclose(out);
+  }
+
+  REQUIRE(pure::journal_reader<table>(file.path.c_str()).size() == 2);
+  {
+    pure::event_journal<table> journal(file.path.c_str());
+    REQUIRE(journal.append<EventCA>(0));
+  }
+
+  pure::journal_reader<table> reader(file.path.c_str());
+  REQUIRE(reader.size() == 3);
+  machine_t machine;
+  REQUIRE(reader.replay(&machine, 1) == 3);
+  REQUIRE(machine.snapshot().cell == machine_t().snapshot().cell);
+}
+
+TEST_CASE("Failed commit leaves no records in the journal") {
+  temp_file file;
+  using journal_t = pure::event_journal<table, none, 4>;
+  journal_t journal(file.path.c_str());
+  REQUIRE(journal.is_open());
+
+  // Writes past the limit fail with EFBIG instead of raising SIGXFSZ, so a
+  // group of 4 records is written only in part.
+  rlimit limit {};
+  REQUIRE(getrlimit(RLIMIT_FSIZE, &limit) == 0);
+  const rlimit saved = limit;
+  const auto old_handler = signal(SIGXFSZ, SIG_IGN);
+  limit.rlim_cur = sizeof(pure::__details::journal_header) +
+                   sizeof(journal_t::record_type) + 3;
+  REQUIRE(setrlimit(RLIMIT_FSIZE, &limit) == 0);
+
+  REQUIRE(journal.append<EventAB>(0));
+  REQUIRE(journal.append<EventBC>(0));
+  REQUIRE(journal.append<EventCA>(0));
+  REQUIRE_FALSE(journal.append<EventAB>(0));
+  REQUIRE(journal.pending() == 4);
+  REQUIRE(pure::journal_reader<table>(file.path.c_str()).size() == 0);
+
+  REQUIRE(setrlimit(RLIMIT_FSIZE, &saved) == 0);
+  signal(SIGXFSZ, old_handler);
+  REQUIRE(journal.commit());
+  REQUIRE(journal.pending() == 0);
+
+  pure::journal_reader<table> reader(file.path.c_str());
+  REQUIRE(reader.size() == 4);
+  machine_t machine;
+  REQUIRE(reader.replay(&machine, 1) == 4);
+}
+
+TEST_CASE("Journal, that is not open, takes no records") {
+  pure::event_journal<table> journal("/nonexistent/purefsm_journal.bin");
+  REQUIRE_FALSE(journal.is_open());
+  REQUIRE_FALSE(journal.append<EventAB>(0));
+  REQUIRE(journal.pending() == 0);
+  REQUIRE_FALSE(journal.commit());
+}
+
+TEST_CASE("Padding of journal records is written as zeros") {
+  struct Tag {
+    char value;
+  };
+  using journal_t = pure::event_journal<table, Tag>;
+  static_assert(sizeof(journal_t::record_type) == 12);
+
+  temp_file file;
+  {
+    journal_t journal(file.path.c_str());
+    REQUIRE(journal.append<EventAB>(1, Tag {'x'}));
+    REQUIRE(journal.append<EventBC>(2, Tag {'y'}));
+  }
+
+  std::FILE* in = std::fopen(file.path.c_str(), "rb");
+  REQUIRE(in);
+  unsigned char bytes[32 + 2 * 12] = {};
+  REQUIRE(std::fread(bytes, 1, sizeof(bytes), in) == sizeof(bytes));
+  std::fclose(in);
+
+  // Every record: machine, event, tag and three bytes of padding
+  for (std::size_t rec = 0; rec < 2; ++rec) {
+    const unsigned char* record = bytes + 32 + rec * 12;
+    REQUIRE(record[8] == (rec ? 'y' : 'x'));
+    for (std::size_t idx = 9; idx < 12; ++idx) REQUIRE(record[idx] == 0);
+  }
+}
@@ -0,0 +1,124 @@
+#include <catch2/catch_test_macros.hpp>
+#include <pure/fsm.hpp>
+#include <random>
+#include <type_traits>
+#include <utility>
+
+template <std::size_t I>
+struct State {
+  void operator()(std::size_t& state) { state = I; }
+};
+
+template <std::size_t I>
+struct Event {};
+
+struct Final {
+  void operator()(std::size_t& state);
+};
+
+struct Leave {};
+
+constexpr std::size_t state_count = 512;
+constexpr std::size_t event_count = 8;
+
+void Final::operator()(std::size_t& state) { state = state_count; }
+
+/*
+ * A ring of states: the state I goes to the next one by the event I % 8,
+ * and every state leaves to Final, that is only a target.
+ */
+template <std::size_t... Is>
+auto make_table(std::index_sequence<Is...>)
+    -> pure::transition_table<
+        pure::tr<State<Is>, Event<Is % event_count>,
+                 State<(Is + 1) % state_count>, pure::none, pure::none>...,
+        pure::tr<State<Is>, Leave, Final, pure::none, pure::none>...>;
+
+using table = decltype(make_table(std::make_index_sequence<state_count> {}));
+
+struct dense_table : table {};
+
+template <>
+struct pure::table_layout<dense_table> {
+  static constexpr dispatch_layout value = dispatch_layout::dense;
+};
+
+TEST_CASE("Distinct types keep the order of their first appearance") {
+  using pure::__details::unique_t;
+
+  STATIC_REQUIRE(std::is_same_v<unique_t<tp::type_pack<int, char, int, long,
+                                                       char, long, int>>,
+                                tp::type_pack<int, char, long>>);
+  STATIC_REQUIRE(
+      std::is_same_v<unique_t<tp::type_pack<int, int>>, tp::type_pack<int>>);
+  STATIC_REQUIRE(std::is_same_v<unique_t<tp::empty_pack>, tp::empty_pack>);
+}
+
+TEST_CASE("Collections of a large table") {
+  using states = typename table::state_collection;
+  using events = typename table::event_collection;
+
+  STATIC_REQUIRE(states::size() == state_count + 1);
+  STATIC_REQUIRE(std::is_same_v<tp::at_t<0, states>, State<0>>);
+  STATIC_REQUIRE(std::is_same_v<tp::at_t<511, states>, State<511>>);
+  STATIC_REQUIRE(std::is_same_v<tp::at_t<state_count, states>, Final>);
+
+  STATIC_REQUIRE(events::size() == event_count + 1);
+  STATIC_REQUIRE(std::is_same_v<tp::at_t<7, events>, Event<7>>);
+  STATIC_REQUIRE(std::is_same_v<tp::at_t<event_count, events>, Leave>);
+}
+
+TEST_CASE("Dispatch in a large table") {
+  using machine_t = pure::state_machine<table>;
+  machine_t machine;
+  std::size_t state = 0;
+
+  for (std::size_t idx = 0; idx < state_count; ++idx) {
+    REQUIRE(machine.dispatch(idx % event_count));
+    REQUIRE_FALSE(machine.dispatch((idx + 2) % event_count));
+  }
+  machine.action(state);
+  REQUIRE(state == 0);
+
+  REQUIRE(machine.dispatch(0));
+  machine.action(state);
+  REQUIRE(state == 1);
+
+  REQUIRE(machine.dispatch(machine_t::event_id<Leave>));
+  machine.action(state);
+  REQUIRE(state == state_count);
+  REQUIRE_FALSE(machine.dispatch(0));
+}
+
+TEST_CASE("Sparse dispatch table is displaced") {
+  using report = pure::dispatch_report<table>;
+  using dense_report = pure::dispatch_report<dense_table>;
+  using small_report = pure::dispatch_report<pure::transition_table<
+      pure::tr<State<0>, Leave, Final, pure::none, pure::none>>>;
+
+  STATIC_REQUIRE(report::layout == pure::dispatch_layout::displaced);
+  STATIC_REQUIRE(report::entries == 2 * state_count);
+  STATIC_REQUIRE(report::bytes * 2 <= report::dense_bytes);
+  STATIC_REQUIRE(dense_report::layout == pure::dispatch_layout::dense);
+  STATIC_REQUIRE(dense_report::bytes == report::dense_bytes);
+  STATIC_REQUIRE(small_report::layout == pure::dispatch_layout::dense);
+
+  pure::state_machine<table> machine;
+  pure::state_machine<dense_table> dense;
+  std::size_t state = 0;
+  std::size_t dense_state = 0;
+  std::mt19937 random(5);
+
+  for (int step = 0; step < 20000; ++step) {
+    const std::size_t id = random() % (event_count + 1);
+    REQUIRE(machine.dispatch(id) == dense.dispatch(id));
+    machine.action(state);
+    dense.action(dense_state);
+    REQUIRE(state == dense_state);
+    // Final has no transitions, so the ring is entered again
+    if (state == state_count) {
+      machine = {};
+      dense = {};
+    }
+  }
+}
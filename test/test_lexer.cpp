@@ -0,0 +1,135 @@
+#include <catch2/catch_test_macros.hpp>
+#include <pure/fsm.hpp>
+#include <pure/lexer.hpp>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct Space {};
+
+struct Number {};
+
+struct Word {};
+
+struct String {};
+
+struct Escape {};
+
+struct Error {};
+
+struct End {};
+
+struct Hex {};
+
+struct Tokens {
+  const char* begin = nullptr;
+  std::vector<std::string> list;
+};
+
+struct Begin {
+  void operator()(const char* at, Tokens& tokens) { tokens.begin = at; }
+};
+
+struct Emit {
+  void operator()(const char* at, Tokens& tokens) {
+    tokens.list.emplace_back(tokens.begin, at);
+  }
+};
+
+// Strings are emitted with their closing quote
+struct EmitString {
+  void operator()(const char* at, Tokens& tokens) {
+    tokens.list.emplace_back(tokens.begin, at + 1);
+  }
+};
+
+struct Fail {
+  void operator()(Tokens& tokens) { tokens.list.emplace_back("!"); }
+};
+
+using digit = pure::byte_range<'0', '9'>;
+using lower = pure::byte_range<'a', 'z'>;
+using blank = pure::byte_set<' ', '\n', '\t'>;
+using quote = pure::byte_set<'"'>;
+using backslash = pure::byte_set<'\\'>;
+
+using pure::any_byte;
+using pure::none;
+using pure::tr;
+
+using table = pure::transition_table<
+    tr<Space, digit, Number, Begin, none>,
+    tr<Space, lower, Word, Begin, none>,
+    tr<Space, quote, String, Begin, none>,
+    tr<Number, digit, Number, none, none>,
+    tr<Number, pure::byte_range<'a', 'f'>, Number, none, Hex>,
+    tr<Number, blank, Space, Emit, none>,
+    tr<Number, lower, Error, Fail, none>,
+    tr<Number, End, Space, none, none>,
+    tr<Word, lower, Word, none, none>,
+    tr<Word, digit, Word, none, none>,
+    tr<Word, blank, Space, Emit, none>,
+    tr<String, backslash, Escape, none, none>,
+    tr<String, quote, Space, EmitString, none>,
+    tr<String, any_byte, String, none, none>,
+    tr<Escape, any_byte, String, none, none>,
+    tr<Error, blank, Space, none, none>>;
+
+using lexer_t = pure::byte_lexer<table>;
+
+TEST_CASE("Bytes are passed by their classes") {
+  lexer_t lexer;
+  Tokens tokens;
+  const std::string_view input = "abc 123  \"x\\\"y z\" d4\n12ab ";
+
+  // Idle transitions in a word, a number or a string are not counted
+  REQUIRE(lexer.feed(input, tokens) == 13);
+  REQUIRE(lexer.is_in<Space>());
+  REQUIRE(tokens.list == std::vector<std::string> {
+                             "abc", "123", "\"x\\\"y z\"", "d4", "!"});
+
+  lexer.guard<Hex>();
+  REQUIRE(lexer.feed("12ab ", tokens) == 2);
+  REQUIRE(tokens.list.back() == "12ab");
+}
+
+TEST_CASE("Other events are passed by the type") {
+  lexer_t lexer;
+  Tokens tokens;
+  REQUIRE(lexer.feed("42", tokens) == 1);
+  REQUIRE(lexer.is_in<Number>());
+  REQUIRE(lexer.event<End>(tokens));
+  REQUIRE(lexer.is_in<Space>());
+  REQUIRE_FALSE(lexer.event<End>(tokens));
+}
+
+TEST_CASE("Buffer is lexed as its parts") {
+  const char alphabet[] = "abc019 \n\"\\x";
+  std::mt19937 random(11);
+  std::string input;
+  while (input.size() < 100000) {
+    // Long runs of one byte class exercise the skipping
+    const char byte = alphabet[random() % (sizeof(alphabet) - 1)];
+    input.append(random() % 4 ? 1 : random() % 200, byte);
+  }
+
+  lexer_t whole;
+  Tokens whole_tokens;
+  const std::size_t count = whole.feed(input, whole_tokens);
+
+  lexer_t parts;
+  Tokens part_tokens;
+  std::size_t part_count = 0;
+  for (std::size_t pos = 0; pos < input.size();) {
+    const std::size_t size = random() % 64;
+    part_count +=
+        parts.feed(std::string_view(input).substr(pos, size), part_tokens);
+    pos += size;
+  }
+
+  REQUIRE(count > 1000);
+  REQUIRE(count == part_count);
+  REQUIRE(whole.state() == parts.state());
+  REQUIRE(whole_tokens.list == part_tokens.list);
+}
@@ -0,0 +1,198 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <fcntl.h>
+#include <pure/fsm.hpp>
+#include <pure/mapped_store.hpp>
+#include <string>
+#include <unistd.h>
+
+struct StateA {};
+
+struct StateB {};
+
+struct StateC {};
+
+struct EventAB {};
+
+struct EventBC {};
+
+struct EventCA {};
+
+struct Armed {};
+
+struct CountAction {
+  void operator()(int& counter) { ++counter; }
+};
+
+using pure::none;
+using pure::tr;
+
+using table =
+    pure::transition_table<tr<StateA, EventAB, StateB, CountAction, none>,
+                           tr<StateB, EventBC, StateC, none, Armed>,
+                           tr<StateC, EventCA, StateA, none, none>>;
+
+using other_table =
+    pure::transition_table<tr<StateA, EventAB, StateC, none, none>,
+                           tr<StateC, EventBC, StateB, none, Armed>,
+                           tr<StateB, EventCA, StateA, none, none>>;
+
+/*
+ * Path of a fresh file in the temporary directory, that is removed at the
+ * end of a test case.
+ */
+struct temp_file {
+  std::string path;
+
+  temp_file() {
+    const char* dir = std::getenv("TMPDIR");
+    path = std::string(dir ? dir : "/tmp") + "/purefsm_store_" +
+           std::to_string(getpid()) + ".bin";
+    std::remove(path.c_str());
+  }
+
+  ~temp_file() { std::remove(path.c_str()); }
+};
+
+TEST_CASE("States of a mapped store are recovered by reopening") {
+  temp_file file;
+  int counter = 0;
+
+  {
+    pure::mapped_machine_store<table> store(file.path.c_str(), 100);
+    REQUIRE(store.is_open());
+    REQUIRE_FALSE(store.recovered());
+    REQUIRE(store.size() == 100);
+    for (std::size_t idx = 0; idx < store.size(); ++idx)
+      REQUIRE(store.is_in<StateA>(idx));
+
+    REQUIRE(store.event<EventAB>(3, counter));
+    REQUIRE(counter == 1);
+    REQUIRE(store.event<EventAB>(7, counter));
+    store.guard<Armed>(7);
+    REQUIRE(store.event<EventBC>(7));
+    REQUIRE_FALSE(store.event<EventBC>(3));
+    REQUIRE_FALSE(store.dispatch(3, 42));
+    REQUIRE(store.is_in<StateB>(3));
+    REQUIRE(store.is_in<StateC>(7));
+  }
+
+  pure::mapped_machine_store<table> store(file.path.c_str(), 100);
+  REQUIRE(store.is_open());
+  REQUIRE(store.recovered());
+  REQUIRE(store.is_in<StateA>(0));
+  REQUIRE(store.is_in<StateB>(3));
+  REQUIRE(store.is_in<StateC>(7));
+
+  // The guard is recovered too
+  REQUIRE(store.dispatch(7, store.event_id<EventCA>));
+  REQUIRE(store.event<EventAB>(7, counter));
+  REQUIRE(store.event<EventBC>(7));
+  REQUIRE(store.is_in<StateC>(7));
+
+  pure::state_machine<table> machine;
+  REQUIRE(machine.restore(store.snapshot(3)));
+  REQUIRE(machine.snapshot().cell == store.snapshot(3).cell);
+  REQUIRE_FALSE(machine.dispatch(store.event_id<EventAB>));
+}
+
+TEST_CASE("Mapped store rejects a file of another store") {
+  temp_file file;
+
+  {
+    pure::mapped_machine_store<table> store(file.path.c_str(), 10);
+    REQUIRE(store.is_open());
+    REQUIRE(store.event<EventAB>(0));
+  }
+
+  SECTION("Another number of machines") {
+    pure::mapped_machine_store<table> store(file.path.c_str(), 11);
+    REQUIRE_FALSE(store.is_open());
+    REQUIRE(store.size() == 0);
+  }
+
+  SECTION("Another table") {
+    pure::mapped_machine_store<other_table> store(file.path.c_str(), 10);
+    REQUIRE_FALSE(store.is_open());
+  }
+
+  // The rejected file is left untouched
+  pure::mapped_machine_store<table> store(file.path.c_str(), 10);
+  REQUIRE(store.recovered());
+  REQUIRE(store.is_in<StateB>(0));
+}
+
+/*
+ * Writes the bytes at the offset of the file.
+ */
+static bool patch(const std::string& path, off_t offset, const void* data,
+                  std::size_t size) {
+  const int fd = ::open(path.c_str(), O_WRONLY);
+  if (fd < 0) return false;
+  const bool written =
+      pwrite(fd, data, size, offset) == static_cast<ssize_t>(size);
+  ::close(fd);
+  return written;
+}
+
+TEST_CASE("Mapped store rejects a file with a corrupted cell") {
+  temp_file file;
+  {
+    pure::mapped_machine_store<table> store(file.path.c_str(), 10);
+    REQUIRE(store.is_open());
+  }
+
+  // Cells of the table are single bytes after the header of 32 bytes
+  const unsigned char cell = 200;
+  REQUIRE(patch(file.path, 32, &cell, 1));
+
+  pure::mapped_machine_store<table> store(file.path.c_str(), 10);
+  REQUIRE_FALSE(store.is_open());
+}
+
+TEST_CASE("Mapped store initializes a file, left by a crash") {
+  temp_file file;
+  {
+    pure::mapped_machine_store<table> store(file.path.c_str(), 10);
+    REQUIRE(store.event<EventAB>(0));
+  }
+
+  // The crash came before the magic was written
+  const std::uint64_t magic = 0;
+  REQUIRE(patch(file.path, 0, &magic, sizeof(magic)));
+
+  {
+    pure::mapped_machine_store<table> store(file.path.c_str(), 10);
+    REQUIRE(store.is_open());
+    REQUIRE_FALSE(store.recovered());
+    REQUIRE(store.is_in<StateA>(0));
+  }
+
+  pure::mapped_machine_store<table> store(file.path.c_str(), 10);
+  REQUIRE(store.recovered());
+}
+
+TEST_CASE("Sync policies of a mapped store") {
+  temp_file file;
+
+  {
+    pure::mapped_machine_store<table, pure::msync_batch<4>> store(
+        file.path.c_str(), 5000);
+    REQUIRE(store.is_open());
+    for (std::size_t idx = 0; idx < store.size(); idx += 7)
+      REQUIRE(store.event<EventAB>(idx));
+    store.flush();
+  }
+
+  pure::mapped_machine_store<table, pure::fdatasync_batch<16>> store(
+      file.path.c_str(), 5000);
+  REQUIRE(store.recovered());
+  for (std::size_t idx = 0; idx < store.size(); ++idx) {
+    if (idx % 7 == 0)
+      REQUIRE(store.is_in<StateB>(idx));
+    else
+      REQUIRE(store.is_in<StateA>(idx));
+  }
+}
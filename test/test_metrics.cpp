@@ -0,0 +1,129 @@
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <pure/fsm.hpp>
+#include <pure/metrics.hpp>
+#include <thread>
+
+struct StateA {};
+
+struct StateB {};
+
+struct Forward {};
+
+struct Back {};
+
+struct Work {
+  void operator()(int& calls) { ++calls; }
+};
+
+using pure::none;
+using pure::tr;
+
+using table = pure::transition_table<tr<StateA, Forward, StateB, Work, none>,
+                                     tr<StateB, Back, StateA, none, none>>;
+
+TEST_CASE("Transition metrics") {
+  using buckets = pure::log_linear_buckets;
+
+  SECTION("Empty metrics take no space") {
+    STATIC_REQUIRE(sizeof(pure::state_machine<table>) ==
+                   sizeof(pure::state_machine<table, pure::empty_logger,
+                                              pure::empty_metrics>));
+    STATIC_REQUIRE(sizeof(pure::state_machine<table>) == 2);
+  }
+
+  SECTION("Counters") {
+    using metrics_t = pure::transition_metrics<table>;
+    pure::state_machine<table, pure::empty_logger, metrics_t> machine;
+    int calls = 0;
+
+    machine.event<Forward>(calls);
+    machine.event<Forward>(calls);
+    machine.event<Back>(calls);
+    machine.dispatch(machine.event_id<Back>, calls);
+    machine.event<Forward>(calls);
+
+    const auto snapshot = machine.metrics().snapshot();
+    REQUIRE(calls == 2);
+    REQUIRE(snapshot.fired[0] == 2);
+    REQUIRE(snapshot.fired[1] == 1);
+    REQUIRE(machine.metrics().fired(0) == 2);
+    REQUIRE(snapshot.unhandled[metrics_t::unhandled_index<StateB, Forward>] ==
+            1);
+    REQUIRE(snapshot.unhandled[metrics_t::unhandled_index<StateA, Back>] ==
+            1);
+    REQUIRE(snapshot.unhandled[metrics_t::unhandled_index<StateA, Forward>] ==
+            0);
+  }
+
+  SECTION("Batch processing is counted") {
+    using metrics_t = pure::transition_metrics<table>;
+    pure::state_machine<table, pure::empty_logger, metrics_t> machine;
+    const std::size_t events[] = {0, 1, 1, 0};
+
+    REQUIRE(machine.process(events) == 3);
+    REQUIRE(machine.metrics().fired(0) == 2);
+    REQUIRE(machine.metrics().fired(1) == 1);
+  }
+
+  SECTION("Latency histograms") {
+    using metrics_t = pure::transition_metrics<table, true>;
+    metrics_t metrics;
+    pure::state_machine<table, pure::empty_logger, metrics_t&> machine(
+        pure::empty_logger {}, metrics);
+    int calls = 0;
+
+    for (int i = 0; i < 10; ++i) {
+      machine.event<Forward>(calls);
+      machine.event<Back>(calls);
+    }
+
+    const auto snapshot = metrics.snapshot();
+    std::uint64_t total = 0;
+    for (auto count : snapshot.latency[0]) total += count;
+    REQUIRE(total == 10);
+    REQUIRE(snapshot.fired[1] == 10);
+  }
+
+  SECTION("Log-linear buckets") {
+    STATIC_REQUIRE(buckets::bucket(0) == 0);
+    STATIC_REQUIRE(buckets::bucket(7) == 7);
+    STATIC_REQUIRE(buckets::bucket(8) == 8);
+    STATIC_REQUIRE(buckets::bucket(10) == 9);
+    STATIC_REQUIRE(buckets::bucket(16) == 12);
+    STATIC_REQUIRE(buckets::bucket(~std::uint64_t(0)) ==
+                   buckets::bucket_count - 1);
+
+    for (std::size_t b = 0; b < buckets::bucket_count; ++b)
+      REQUIRE(buckets::bucket(buckets::lower_bound(b)) == b);
+  }
+
+  SECTION("Snapshots from another thread") {
+    using metrics_t = pure::transition_metrics<table>;
+    metrics_t metrics;
+    pure::state_machine<table, pure::empty_logger, metrics_t&> machine(
+        pure::empty_logger {}, metrics);
+    std::atomic<bool> done {false};
+    bool monotonic = true;
+
+    std::thread scraper([&] {
+      std::uint64_t last = 0;
+      while (!done.load()) {
+        const auto fired = metrics.snapshot().fired[0];
+        monotonic = monotonic && fired >= last;
+        last = fired;
+      }
+    });
+    int calls = 0;
+    for (int i = 0; i < 100000; ++i) {
+      machine.event<Forward>(calls);
+      machine.event<Back>(calls);
+    }
+    done.store(true);
+    scraper.join();
+
+    REQUIRE(monotonic);
+    REQUIRE(metrics.fired(0) == 100000);
+  }
+}
@@ -0,0 +1,173 @@
+#include <catch2/catch_test_macros.hpp>
+#include <pure/fsm.hpp>
+#include <pure/minimize.hpp>
+#include <random>
+#include <type_traits>
+
+struct Idle {};
+
+struct Busy {};
+
+struct BusyCopy {};
+
+struct Done {};
+
+struct DoneCopy {};
+
+struct Paused {};
+
+struct Held {};
+
+struct HeldCopy {};
+
+struct Waiting {};
+
+struct WaitingCopy {};
+
+struct Alarm {
+  void operator()(int& alarms) { ++alarms; }
+};
+
+struct AlarmCopy {
+  void operator()(int& alarms) { ++alarms; }
+};
+
+struct Start {};
+
+struct Retry {};
+
+struct Finish {};
+
+struct Cancel {};
+
+struct Reset {};
+
+struct Pause {};
+
+struct Hold {};
+
+struct Tick {};
+
+struct Wait {};
+
+struct Go {};
+
+struct Panic {};
+
+struct Armed {};
+
+struct Count {
+  void operator()(int& calls) { ++calls; }
+};
+
+struct Ready {
+  bool operator()(int& calls) const { return calls % 2 == 0; }
+};
+
+using pure::none;
+using pure::tr;
+using pure::when;
+
+using table = pure::transition_table<
+    tr<Idle, Start, Busy, none, none>,
+    tr<Idle, Retry, BusyCopy, none, none>,
+    tr<Busy, Finish, Done, Count, none>,
+    tr<BusyCopy, Finish, DoneCopy, Count, none>,
+    tr<Busy, Cancel, Idle, none, none>,
+    tr<BusyCopy, Cancel, Idle, none, none>,
+    tr<Done, Reset, Idle, none, none>,
+    tr<DoneCopy, Reset, Idle, none, none>,
+    // Differs from Busy by the action
+    tr<Idle, Pause, Paused, none, none>,
+    tr<Paused, Finish, Done, none, none>,
+    tr<Paused, Cancel, Idle, none, none>,
+    // Equal predicate chains, the self loops lead to the same block
+    tr<Idle, Hold, Held, none, none>,
+    tr<Paused, Hold, HeldCopy, none, none>,
+    tr<Held, Tick, Idle, Count, when<Ready>>,
+    tr<Held, Tick, Held, none, none>,
+    tr<HeldCopy, Tick, Idle, Count, when<Ready>>,
+    tr<HeldCopy, Tick, HeldCopy, none, none>,
+    // Differs from Waiting by the guard
+    tr<Idle, Wait, Waiting, none, none>,
+    tr<Paused, Wait, WaitingCopy, none, none>,
+    tr<Waiting, Go, Idle, none, Armed>,
+    tr<WaitingCopy, Go, Idle, none, none>,
+    // States with state actions are never merged
+    tr<Idle, Panic, Alarm, none, none>,
+    tr<Paused, Panic, AlarmCopy, none, none>,
+    tr<Alarm, Reset, Idle, none, none>,
+    tr<AlarmCopy, Reset, Idle, none, none>>;
+
+using minimal = pure::minimize<table>;
+
+TEST_CASE("Equivalent states are merged") {
+  using states = typename minimal::state_collection;
+
+  STATIC_REQUIRE(table::state_collection::size() == 12);
+  STATIC_REQUIRE(states::size() == 9);
+  STATIC_REQUIRE(std::is_same_v<minimal::state_t<BusyCopy>, Busy>);
+  STATIC_REQUIRE(std::is_same_v<minimal::state_t<DoneCopy>, Done>);
+  STATIC_REQUIRE(std::is_same_v<minimal::state_t<HeldCopy>, Held>);
+  STATIC_REQUIRE(std::is_same_v<minimal::state_t<Paused>, Paused>);
+  STATIC_REQUIRE(std::is_same_v<minimal::state_t<WaitingCopy>, WaitingCopy>);
+  STATIC_REQUIRE(std::is_same_v<minimal::state_t<AlarmCopy>, AlarmCopy>);
+
+  STATIC_REQUIRE(
+      minimal::state_map[pure::__details::index_of<BusyCopy>(
+          table::state_collection {})] ==
+      pure::__details::index_of<Busy>(states {}));
+  STATIC_REQUIRE(std::is_same_v<minimal::event_collection,
+                                table::event_collection>);
+  STATIC_REQUIRE(std::is_same_v<minimal::guard_collection,
+                                table::guard_collection>);
+}
+
+TEST_CASE("Minimal table behaves as the original one") {
+  using original_t = pure::state_machine<table>;
+  using minimal_t = pure::state_machine<minimal>;
+  using compiled = pure::__details::compiled_table<table>;
+
+  original_t original;
+  minimal_t machine;
+  int original_calls = 0;
+  int calls = 0;
+  std::mt19937 random(3);
+
+  for (int step = 0; step < 5000; ++step) {
+    if (random() % 10 == 0) {
+      original.guard<Armed>();
+      machine.guard<Armed>();
+    } else if (random() % 10 == 0) {
+      original.guard<none>();
+      machine.guard<none>();
+    }
+
+    const std::size_t id = random() % compiled::event_count;
+    REQUIRE(original.dispatch(id, original_calls) ==
+            machine.dispatch(id, calls));
+    REQUIRE(original_calls == calls);
+
+    const std::size_t state = original.snapshot().cell / compiled::guard_count;
+    REQUIRE(machine.snapshot().cell /
+                pure::__details::compiled_table<minimal>::guard_count ==
+            minimal::state_map[state]);
+  }
+  REQUIRE(calls > 0);
+}
+
+TEST_CASE("Original states are mapped to their representatives") {
+  using compiled = pure::__details::compiled_table<minimal>;
+  pure::state_machine<minimal> machine;
+  int calls = 0;
+
+  auto state = [&machine] {
+    return machine.snapshot().cell / compiled::guard_count;
+  };
+
+  machine.event<Retry>(calls);
+  REQUIRE(state() == compiled::state_index<minimal::state_t<BusyCopy>>);
+  machine.event<Finish>(calls);
+  REQUIRE(state() == compiled::state_index<minimal::state_t<DoneCopy>>);
+  REQUIRE(calls == 1);
+}
@@ -0,0 +1,130 @@
+#include <catch2/catch_test_macros.hpp>
+#include <iostream>
+#include <pure/logger.hpp>
+#include <pure/multi_guard.hpp>
+
+enum class current_state { None, A, B, C, D };
+
+struct StateA {
+  void operator()(current_state& state) { state = current_state::A; }
+};
+
+struct StateB {
+  void operator()(current_state& state) { state = current_state::B; }
+};
+
+struct StateC {
+  void operator()(current_state& state) { state = current_state::C; }
+};
+
+struct StateD {
+  void operator()(current_state& state) { state = current_state::D; }
+};
+
+struct Event {};
+
+struct Back {};
+
+struct GuardA {};
+
+struct GuardB {};
+
+struct GuardC {};
+
+TEST_CASE("Multiple active guards") {
+  current_state state = current_state::None;
+
+  using pure::any_of;
+  using pure::none;
+  using pure::none_of;
+  using pure::tr;
+
+  using table = pure::transition_table<
+      tr<StateA, Event, StateB, none, GuardA>,
+      tr<StateA, Event, StateC, none, any_of<GuardB, GuardC>>,
+      tr<StateA, Event, StateD, none, none_of<GuardA, GuardB>>,
+      tr<StateB, Back, StateA, none, none>,
+      tr<StateC, Back, StateA, none, none>,
+      tr<StateD, Back, StateA, none, none>>;
+  using logger = pure::stdout_logger<std::cout>;
+  using machine_t = pure::multi_guard_machine<table, logger>;
+  machine_t machine;
+
+  STATIC_REQUIRE(sizeof(pure::multi_guard_machine<table>) == 2);
+
+  machine.action(state);
+  REQUIRE(state == current_state::A);
+  REQUIRE(machine.is_set<none>());
+
+  SECTION("No guard is active") {
+    machine.event<Event>();
+    machine.action(state);
+
+    REQUIRE(state == current_state::D);
+  }
+
+  SECTION("The first matching transition is performed") {
+    machine.set_guard<GuardA>();
+    machine.set_guard<GuardC>();
+    REQUIRE(machine.is_set<GuardA>());
+    REQUIRE(machine.is_set<GuardC>());
+    REQUIRE_FALSE(machine.is_set<none>());
+
+    machine.event<Event>();
+    machine.action(state);
+
+    REQUIRE(state == current_state::B);
+  }
+
+  SECTION("Clearing a guard") {
+    machine.set_guard<GuardA>();
+    machine.set_guard<GuardC>();
+    machine.clear_guard<GuardA>();
+    REQUIRE_FALSE(machine.is_set<GuardA>());
+
+    machine.event<Event>();
+    machine.action(state);
+
+    REQUIRE(state == current_state::C);
+  }
+
+  SECTION("Clearing the last guard activates none") {
+    machine.set_guard<GuardB>();
+    machine.clear_guard<GuardB>();
+    REQUIRE(machine.is_set<none>());
+
+    REQUIRE(machine.dispatch(machine_t::event_id<Event>));
+    machine.action(state);
+
+    REQUIRE(state == current_state::D);
+  }
+
+  SECTION("guard replaces the set of active guards") {
+    machine.set_guard<GuardA>();
+    machine.guard<GuardB>();
+    REQUIRE_FALSE(machine.is_set<GuardA>());
+
+    machine.event<Event>();
+    machine.action(state);
+
+    REQUIRE(state == current_state::C);
+
+    machine.event<Back>();
+    machine.guard<none>();
+    machine.event<Event>();
+    machine.action(state);
+
+    REQUIRE(state == current_state::D);
+  }
+
+  SECTION("An event without a matching transition") {
+    machine.set_guard<GuardB>();
+    machine.set_guard<GuardA>();
+    machine.clear_guard<GuardA>();
+    machine.clear_guard<GuardB>();
+    machine.guard<GuardB>();
+
+    REQUIRE_FALSE(machine.dispatch(machine_t::event_id<Back>));
+    REQUIRE_FALSE(machine.dispatch(100));
+  }
+}
@@ -0,0 +1,88 @@
+#include <catch2/catch_test_macros.hpp>
+#include <pure/fsm.hpp>
+#include <pure/parallel.hpp>
+#include <string>
+
+struct Off {
+  void operator()(std::string& log) { log += "Off "; }
+};
+
+struct On {
+  void operator()(std::string& log) { log += "On "; }
+};
+
+struct Locked {
+  void operator()(std::string& log) { log += "Locked "; }
+};
+
+struct Unlocked {
+  void operator()(std::string& log) { log += "Unlocked "; }
+};
+
+struct Quiet {};
+
+struct Loud {};
+
+struct Power {};
+
+struct Key {};
+
+struct Volume {};
+
+struct Armed {};
+
+struct Count {
+  void operator()(int& calls) { ++calls; }
+};
+
+using pure::none;
+using pure::tr;
+
+using power_table = pure::transition_table<tr<Off, Power, On, Count, none>,
+                                           tr<On, Power, Off, Count, none>>;
+
+using lock_table =
+    pure::transition_table<tr<Locked, Key, Unlocked, Count, Armed>,
+                           tr<Unlocked, Key, Locked, Count, none>,
+                           tr<Unlocked, Power, Locked, none, none>>;
+
+using volume_table =
+    pure::transition_table<tr<Quiet, Volume, Loud, none, none>,
+                           tr<Loud, Volume, Quiet, none, none>>;
+
+using machine_t = pure::parallel_machine<power_table, lock_table, volume_table>;
+
+TEST_CASE("Regions of a parallel machine are packed") {
+  STATIC_REQUIRE(sizeof(machine_t) <= 3);
+  STATIC_REQUIRE(machine_t::region_count == 3);
+}
+
+TEST_CASE("Events are passed to every region, that has them") {
+  machine_t machine;
+  int calls = 0;
+
+  REQUIRE(machine.is_in<0, Off>());
+  REQUIRE(machine.is_in<Locked>());
+  REQUIRE_FALSE(machine.is_in<On>());
+
+  REQUIRE(machine.event<Key>(calls) == 0);
+  machine.guard<Armed>();
+  REQUIRE(machine.event<Key>(calls) == 1);
+  REQUIRE(machine.is_in<1, Unlocked>());
+  REQUIRE(calls == 1);
+
+  // Power is in two regions, and one of them calls no action
+  REQUIRE(machine.event<Power>(calls) == 2);
+  REQUIRE(calls == 2);
+  REQUIRE(machine.is_in<On>());
+  REQUIRE(machine.is_in<Locked>());
+
+  REQUIRE(machine.dispatch(machine_t::event_id<Volume>) == 1);
+  REQUIRE(machine.is_in<2, Loud>());
+  REQUIRE(machine.dispatch(machine_t::event_id<Power>, calls) == 1);
+  REQUIRE(machine.dispatch(100) == 0);
+
+  std::string log;
+  machine.action(log);
+  REQUIRE(log == "Off Locked ");
+}
@@ -0,0 +1,95 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <pure/fsm.hpp>
+#include <pure/pool.hpp>
+#include <utility>
+
+struct StateA {};
+
+struct StateB {};
+
+struct StateC {};
+
+struct EventAB {};
+
+struct EventBC {};
+
+struct Guard {};
+
+using pure::none;
+using pure::tr;
+
+using table = pure::transition_table<tr<StateA, EventAB, StateB, none, none>,
+                                     tr<StateB, EventBC, StateC, none, Guard>>;
+
+TEST_CASE("Pool of state machines") {
+  using pool_t = pure::state_machine_pool<table, 100>;
+  pool_t pool;
+  pool_t::mask_t fired;
+
+  for (std::size_t i = 0; i < pool.size(); ++i) REQUIRE(pool.is_in<StateA>(i));
+
+  SECTION("Event is applied to all machines") {
+    REQUIRE(pool.event<EventAB>(&fired) == pool.size());
+    REQUIRE(fired.count() == pool.size());
+    for (std::size_t i = 0; i < pool.size(); ++i)
+      REQUIRE(pool.is_in<StateB>(i));
+
+    REQUIRE(pool.event<EventAB>(&fired) == 0);
+    REQUIRE(fired.count() == 0);
+  }
+
+  SECTION("Event is applied to the selected machines") {
+    pool_t::mask_t selected;
+    for (std::size_t i = 0; i < pool.size(); i += 3) selected.set(i);
+
+    REQUIRE(pool.event<EventAB>(selected, &fired) == selected.count());
+    for (std::size_t i = 0; i < pool.size(); ++i) {
+      REQUIRE(fired.test(i) == (i % 3 == 0));
+      REQUIRE(pool.is_in<StateB>(i) == (i % 3 == 0));
+    }
+  }
+
+  SECTION("Guards are kept per machine") {
+    pool.event<EventAB>();
+    pool.guard<Guard>(7);
+    pool.guard<Guard>(99);
+
+    REQUIRE(pool.event<EventBC>(&fired) == 2);
+    for (std::size_t i = 0; i < pool.size(); ++i) {
+      const bool moved = i == 7 || i == 99;
+      REQUIRE(fired.test(i) == moved);
+      REQUIRE(pool.is_in<StateC>(i) == moved);
+    }
+  }
+}
+
+template <std::size_t I>
+struct Ring {};
+
+struct Next {};
+
+template <std::size_t... Is>
+using ring_table =
+    pure::transition_table<tr<Ring<Is>, Next, Ring<(Is + 1) % sizeof...(Is)>,
+                              none, none>...>;
+
+template <std::size_t... Is>
+auto make_ring(std::index_sequence<Is...>) -> ring_table<Is...>;
+
+TEST_CASE("Pool of state machines with a large table") {
+  using table = decltype(make_ring(std::make_index_sequence<40>()));
+  using pool_t = pure::state_machine_pool<table, 77>;
+  pool_t pool;
+
+  pool_t::mask_t selected;
+  selected.set(0);
+  selected.set(76);
+  pool.event<Next>(selected);
+
+  for (int i = 0; i < 45; ++i) pool.event<Next>();
+
+  REQUIRE(pool.state(0) == 6);
+  REQUIRE(pool.state(1) == 5);
+  REQUIRE(pool.state(76) == 6);
+}
@@ -0,0 +1,174 @@
+#include <catch2/catch_test_macros.hpp>
+#include <iostream>
+#include <pure/fsm.hpp>
+#include <pure/logger.hpp>
+#include <pure/multi_guard.hpp>
+
+enum class current_state { None, A, B, C, D };
+
+struct StateA {
+  void operator()(current_state& state) { state = current_state::A; }
+};
+
+struct StateB {
+  void operator()(current_state& state) { state = current_state::B; }
+};
+
+struct StateC {
+  void operator()(current_state& state) { state = current_state::C; }
+};
+
+struct StateD {
+  void operator()(current_state& state) { state = current_state::D; }
+};
+
+struct Event {};
+
+struct Back {};
+
+struct Guard {};
+
+struct context {
+  int level = 0;
+  int checks = 0;
+  int actions = 0;
+};
+
+struct High {
+  bool operator()(context& ctx) const {
+    ++ctx.checks;
+    return ctx.level > 10;
+  }
+};
+
+struct Positive {
+  bool operator()(context& ctx) const {
+    ++ctx.checks;
+    return ctx.level > 0;
+  }
+};
+
+struct Count {
+  void operator()(context& ctx) const { ++ctx.actions; }
+};
+
+using pure::none;
+using pure::tr;
+using pure::when;
+
+using table =
+    pure::transition_table<tr<StateA, Event, StateB, Count, when<High>>,
+                           tr<StateA, Event, StateC, none, when<Positive>>,
+                           tr<StateA, Event, StateD, none, Guard>,
+                           tr<StateB, Back, StateA, none, none>,
+                           tr<StateC, Back, StateA, none, none>,
+                           tr<StateD, Back, StateA, none, when<High>>>;
+
+TEST_CASE("Predicate guards") {
+  using logger = pure::stdout_logger<std::cout>;
+  pure::state_machine<table, logger> machine;
+  current_state state = current_state::None;
+  context ctx;
+
+  STATIC_REQUIRE(table::guard_collection::size() == 2);
+
+  SECTION("Predicates are checked in the table order") {
+    ctx.level = 20;
+    machine.event<Event>(ctx);
+
+    machine.action(state);
+    REQUIRE(state == current_state::B);
+    REQUIRE(ctx.checks == 1);
+    REQUIRE(ctx.actions == 1);
+  }
+
+  SECTION("A failed predicate passes to the next candidate") {
+    ctx.level = 5;
+    machine.event<Event>(ctx);
+
+    machine.action(state);
+    REQUIRE(state == current_state::C);
+    REQUIRE(ctx.checks == 2);
+    REQUIRE(ctx.actions == 0);
+  }
+
+  SECTION("No predicate holds") {
+    REQUIRE_FALSE(machine.dispatch(table::event_collection::size(), ctx));
+    REQUIRE_FALSE(
+        machine.dispatch(pure::state_machine<table>::event_id<Event>, ctx));
+
+    machine.action(state);
+    REQUIRE(state == current_state::A);
+    REQUIRE(ctx.checks == 2);
+  }
+
+  SECTION("Predicates fall through to a tag guard") {
+    machine.guard<Guard>();
+    machine.event<Event>(ctx);
+
+    machine.action(state);
+    REQUIRE(state == current_state::D);
+    REQUIRE(ctx.checks == 2);
+  }
+
+  SECTION("Predicates of other states are not checked") {
+    machine.guard<Guard>();
+    machine.event<Event>(ctx);
+    machine.event<Event>(ctx);
+    REQUIRE(ctx.checks == 2);
+
+    machine.event<Back>(ctx);
+    machine.action(state);
+    REQUIRE(state == current_state::D);
+    REQUIRE(ctx.checks == 3);
+
+    ctx.level = 20;
+    machine.event<Back>(ctx);
+    machine.action(state);
+    REQUIRE(state == current_state::A);
+  }
+
+  SECTION("Predicates without matching arguments never hold") {
+    ctx.level = 20;
+    machine.event<Event>();
+
+    machine.action(state);
+    REQUIRE(state == current_state::A);
+  }
+
+  SECTION("Batch processing") {
+    using machine_t = pure::state_machine<table>;
+    machine_t batch;
+    const std::size_t events[] = {machine_t::event_id<Event>,
+                                  machine_t::event_id<Back>,
+                                  machine_t::event_id<Event>};
+    ctx.level = 5;
+
+    REQUIRE(batch.process(events, ctx) == 3);
+    batch.action(state);
+    REQUIRE(state == current_state::C);
+    REQUIRE(ctx.checks == 4);
+  }
+}
+
+TEST_CASE("Predicate guards with several active guards") {
+  pure::multi_guard_machine<table> machine;
+  current_state state = current_state::None;
+  context ctx;
+
+  machine.set_guard<Guard>();
+  ctx.level = 5;
+  machine.event<Event>(ctx);
+  machine.action(state);
+  REQUIRE(state == current_state::C);
+
+  REQUIRE(machine.dispatch(
+      pure::multi_guard_machine<table>::event_id<Back>, ctx));
+  REQUIRE(ctx.checks == 2);
+
+  ctx.level = 0;
+  machine.event<Event>(ctx);
+  REQUIRE(ctx.checks == 4);
+  REQUIRE_FALSE(machine.dispatch(
+      pure::multi_guard_machine<table>::event_id<Event>));
+}
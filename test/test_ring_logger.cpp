@@ -0,0 +1,111 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <pure/fsm.hpp>
+#include <pure/ring_logger.hpp>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct StateA {};
+
+struct StateB {};
+
+struct Toggle {};
+
+using pure::none;
+using pure::tr;
+
+using table = pure::transition_table<tr<StateA, Toggle, StateB, none, none>,
+                                     tr<StateB, Toggle, StateA, none, none>>;
+
+static std::vector<std::string> lines_of(const std::string& text) {
+  std::vector<std::string> lines;
+  std::istringstream stream(text);
+  for (std::string line; std::getline(stream, line);) lines.push_back(line);
+  return lines;
+}
+
+static bool ends_with(const std::string& str, const std::string& suffix) {
+  return str.size() >= suffix.size() &&
+         str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+TEST_CASE("Ring logger") {
+  std::ostringstream out;
+
+  SECTION("Records are formatted in order") {
+    {
+      pure::ring_log_sink sink(out);
+      pure::state_machine<table, pure::ring_logger> machine(
+          pure::ring_logger(sink, 7));
+
+      machine.event<Toggle>();
+      machine.guard<none>();
+      sink.stop();
+
+      REQUIRE(sink.dropped() == 0);
+      REQUIRE(sink.pending() == 0);
+    }
+
+    const auto lines = lines_of(out.str());
+    REQUIRE(lines.size() == 3);
+    REQUIRE(ends_with(lines[0], " #7 New event: Toggle"));
+    REQUIRE(ends_with(lines[1], " #7 Change state to StateB"));
+    REQUIRE(ends_with(lines[2], " #7 New guard: pure::none"));
+  }
+
+  SECTION("Records of several threads") {
+    constexpr std::size_t threads = 4;
+    constexpr std::size_t events = 500;
+    {
+      pure::ring_log_sink sink(out);
+      std::vector<std::thread> workers;
+      for (std::size_t t = 0; t < threads; ++t)
+        workers.emplace_back([&sink, t] {
+          pure::state_machine<table, pure::ring_logger> machine(
+              pure::ring_logger(sink, static_cast<std::uint32_t>(t)));
+          for (std::size_t i = 0; i < events; ++i) {
+            machine.event<Toggle>();
+            while (sink.pending() > pure::ring_log_sink::ring_capacity / 2)
+              std::this_thread::yield();
+          }
+        });
+      for (auto& worker : workers) worker.join();
+      sink.stop();
+
+      REQUIRE(sink.dropped() == 0);
+    }
+
+    std::size_t per_machine[threads] = {};
+    for (const auto& line : lines_of(out.str())) {
+      unsigned long long time = 0;
+      unsigned long machine = 0;
+      REQUIRE(std::sscanf(line.c_str(), "%llu #%lu", &time, &machine) == 2);
+      REQUIRE(machine < threads);
+      ++per_machine[machine];
+    }
+    for (std::size_t count : per_machine) REQUIRE(count == 2 * events);
+  }
+
+  SECTION("Rings of exited threads are reused") {
+    constexpr std::size_t threads = 3 * pure::ring_log_sink::max_threads;
+    {
+      pure::ring_log_sink sink(out);
+      for (std::size_t t = 0; t < threads; ++t) {
+        std::thread([&sink] {
+          pure::state_machine<table, pure::ring_logger> machine(
+              pure::ring_logger(sink, 1));
+          machine.event<Toggle>();
+        }).join();
+        while (sink.pending()) std::this_thread::yield();
+      }
+      sink.stop();
+
+      REQUIRE(sink.dropped() == 0);
+    }
+    REQUIRE(lines_of(out.str()).size() == 2 * threads);
+  }
+}
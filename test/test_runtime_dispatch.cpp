@@ -0,0 +1,98 @@
+#include <catch2/catch_test_macros.hpp>
+#include <iostream>
+#include <pure/fsm.hpp>
+#include <pure/logger.hpp>
+
+enum class current_state { None, A, B, C };
+
+struct StateA {
+  void operator()(current_state& state) { state = current_state::A; }
+};
+
+struct StateB {
+  void operator()(current_state& state) { state = current_state::B; }
+};
+
+struct StateC {
+  void operator()(current_state& state) { state = current_state::C; }
+};
+
+struct ActionAB {
+  void operator()(int& calls) { ++calls; }
+};
+
+struct EventAB {};
+
+struct EventBC {};
+
+struct EventCA {};
+
+struct Guard {};
+
+TEST_CASE("Runtime event dispatch") {
+  current_state state = current_state::None;
+
+  using pure::none;
+  using pure::tr;
+
+  using table =
+      pure::transition_table<tr<StateA, EventAB, StateB, ActionAB, none>,
+                             tr<StateB, EventBC, StateC, none, Guard>,
+                             tr<StateC, EventCA, StateA, none, none>>;
+  using logger = pure::stdout_logger<std::cout>;
+  using machine_t = pure::state_machine<table, logger>;
+  machine_t machine;
+
+  STATIC_REQUIRE(machine_t::event_id<EventAB> == 0);
+  STATIC_REQUIRE(machine_t::event_id<EventBC> == 1);
+  STATIC_REQUIRE(machine_t::event_id<EventCA> == 2);
+
+  SECTION("Dispatch by event index") {
+    int calls = 0;
+    REQUIRE(machine.dispatch(machine_t::event_id<EventAB>, calls));
+    machine.action(state);
+
+    REQUIRE(state == current_state::B);
+    REQUIRE(calls == 1);
+  }
+
+  SECTION("Event that does not match the state is ignored") {
+    REQUIRE_FALSE(machine.dispatch(machine_t::event_id<EventCA>));
+    machine.action(state);
+
+    REQUIRE(state == current_state::A);
+  }
+
+  SECTION("Guards are respected") {
+    machine.dispatch(machine_t::event_id<EventAB>);
+    REQUIRE_FALSE(machine.dispatch(machine_t::event_id<EventBC>));
+
+    machine.guard<Guard>();
+    REQUIRE(machine.dispatch(machine_t::event_id<EventBC>));
+    machine.action(state);
+
+    REQUIRE(state == current_state::C);
+  }
+
+  SECTION("Unknown event index is ignored") {
+    REQUIRE_FALSE(machine.dispatch(table::event_collection::size()));
+    machine.action(state);
+
+    REQUIRE(state == current_state::A);
+  }
+
+  SECTION("Dispatch by event variant") {
+    table::event_v event = EventAB {};
+    REQUIRE(machine.dispatch(event));
+
+    event = EventBC {};
+    machine.guard<Guard>();
+    REQUIRE(machine.dispatch(event));
+
+    event = EventCA {};
+    REQUIRE(machine.dispatch(event));
+    machine.action(state);
+
+    REQUIRE(state == current_state::A);
+  }
+}
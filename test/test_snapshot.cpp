@@ -0,0 +1,133 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <pure/fsm.hpp>
+#include <pure/snapshot.hpp>
+#include <vector>
+
+enum class current_state { None, A, B, C };
+
+struct StateA {
+  void operator()(current_state& state) { state = current_state::A; }
+};
+
+struct StateB {
+  void operator()(current_state& state) { state = current_state::B; }
+};
+
+struct StateC {
+  int payload = 0;
+
+  void operator()(current_state& state) { state = current_state::C; }
+};
+
+struct EventAB {};
+
+struct EventBC {};
+
+struct EventCA {};
+
+struct Armed {};
+
+using pure::none;
+using pure::tr;
+
+using table = pure::transition_table<tr<StateA, EventAB, StateB, none, none>,
+                                     tr<StateB, EventBC, StateC, none, Armed>,
+                                     tr<StateC, EventCA, StateA, none, none>>;
+
+using other_table =
+    pure::transition_table<tr<StateA, EventAB, StateC, none, none>,
+                           tr<StateC, EventBC, StateB, none, Armed>,
+                           tr<StateB, EventCA, StateA, none, none>>;
+
+using machine_t = pure::state_machine<table>;
+using other_machine_t = pure::state_machine<other_table>;
+
+TEST_CASE("Fingerprints of tables") {
+  STATIC_REQUIRE(machine_t::fingerprint ==
+                 pure::state_machine<table, pure::empty_logger>::fingerprint);
+  STATIC_REQUIRE(machine_t::fingerprint != other_machine_t::fingerprint);
+}
+
+TEST_CASE("Snapshot and restore a machine") {
+  current_state state = current_state::None;
+
+  machine_t machine;
+  machine.event<EventAB>();
+  machine.guard<Armed>();
+  const pure::machine_snapshot snapshot = machine.snapshot();
+  REQUIRE(snapshot.fingerprint == machine_t::fingerprint);
+
+  machine_t restored;
+  REQUIRE(restored.restore(snapshot));
+  restored.action(state);
+  REQUIRE(state == current_state::B);
+
+  restored.event<EventBC>();
+  restored.action(state);
+  REQUIRE(state == current_state::C);
+
+  SECTION("Snapshot of another table is rejected") {
+    other_machine_t other;
+    REQUIRE_FALSE(other.restore(snapshot));
+    other.action(state);
+    REQUIRE(state == current_state::A);
+  }
+
+  SECTION("Cell out of the table is rejected") {
+    REQUIRE_FALSE(restored.restore({machine_t::fingerprint, 1000}));
+    restored.action(state);
+    REQUIRE(state == current_state::C);
+  }
+}
+
+TEST_CASE("Snapshot and restore an array of machines") {
+  current_state state = current_state::None;
+
+  std::vector<machine_t> machines(5);
+  machines[1].event<EventAB>();
+  machines[2].event<EventAB>();
+  machines[2].guard<Armed>();
+  machines[2].event<EventBC>();
+  machines[3].guard<Armed>();
+
+  std::vector<std::byte> buffer(pure::snapshot_size<table>(machines.size()));
+  REQUIRE(buffer.size() == 16 + machines.size());
+  REQUIRE(pure::save_snapshots(machines.data(), machines.size(),
+                               buffer.data()) == buffer.size());
+
+  std::vector<machine_t> restored(machines.size());
+  REQUIRE(pure::restore_snapshots(restored.data(), restored.size(),
+                                  buffer.data(), buffer.size()));
+  for (std::size_t idx = 0; idx < machines.size(); ++idx)
+    REQUIRE(restored[idx].snapshot().cell == machines[idx].snapshot().cell);
+
+  restored[2].action(state);
+  REQUIRE(state == current_state::C);
+
+  // The guard is restored too
+  restored[3].event<EventAB>();
+  restored[3].event<EventBC>();
+  restored[3].action(state);
+  REQUIRE(state == current_state::C);
+
+  SECTION("Buffer of another number of machines is rejected") {
+    REQUIRE_FALSE(pure::restore_snapshots(restored.data(), 4, buffer.data(),
+                                          buffer.size()));
+  }
+
+  SECTION("Buffer of another table is rejected") {
+    std::vector<other_machine_t> others(machines.size());
+    REQUIRE_FALSE(pure::restore_snapshots(others.data(), others.size(),
+                                          buffer.data(), buffer.size()));
+  }
+
+  SECTION("Damaged buffer is rejected and no machine changes") {
+    std::vector<machine_t> fresh(machines.size());
+    buffer.back() = std::byte {0xff};
+    REQUIRE_FALSE(pure::restore_snapshots(fresh.data(), fresh.size(),
+                                          buffer.data(), buffer.size()));
+    for (const auto& machine : fresh)
+      REQUIRE(machine.snapshot().cell == machine_t().snapshot().cell);
+  }
+}
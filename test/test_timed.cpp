@@ -0,0 +1,125 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstdint>
+#include <pure/fsm.hpp>
+#include <pure/timed.hpp>
+#include <random>
+#include <vector>
+
+struct Idle {};
+
+struct Waiting {};
+
+struct Sleeping {};
+
+struct Connect {};
+
+struct Reply {};
+
+struct Ping {};
+
+struct Sleep {};
+
+struct CountTimeout {
+  void operator()(std::size_t& timeouts) { ++timeouts; }
+};
+
+using pure::after;
+using pure::none;
+using pure::tr;
+using namespace std::chrono_literals;
+
+using timeout_t = after<100>;
+using wake_t = after<10, std::ratio<3600>>;
+
+using table = pure::transition_table<
+    tr<Idle, Connect, Waiting, none, none>,
+    tr<Waiting, Reply, Idle, none, none>,
+    tr<Waiting, Ping, Waiting, none, none>,
+    tr<Waiting, timeout_t, Idle, CountTimeout, none>,
+    tr<Waiting, after<1, std::ratio<1>>, Sleeping, none, none>,
+    tr<Idle, Sleep, Sleeping, none, none>,
+    tr<Sleeping, wake_t, Idle, none, none>>;
+
+using machines_t = pure::timed_machines<table>;
+
+TEST_CASE("Timed events are passed after their timeouts") {
+  machines_t machines(3);
+  std::size_t timeouts = 0;
+  REQUIRE(machines.armed() == 0);
+
+  REQUIRE(machines.event<Connect>(0));
+  REQUIRE(machines.event<Connect>(1));
+  REQUIRE(machines.armed(0));
+
+  REQUIRE(machines.advance(60ms, timeouts) == 0);
+  REQUIRE(machines.event<Ping>(1));
+  REQUIRE(machines.advance(39ms, timeouts) == 0);
+  REQUIRE(machines.is_in<Waiting>(0));
+
+  // The shortest timeout of the state is armed
+  REQUIRE(machines.advance(1ms, timeouts) == 1);
+  REQUIRE(timeouts == 1);
+  REQUIRE(machines.is_in<Idle>(0));
+  REQUIRE_FALSE(machines.armed(0));
+
+  // Ping restarted the timer of the machine 1, a reply cancels it
+  REQUIRE(machines.is_in<Waiting>(1));
+  REQUIRE(machines.event<Reply>(1));
+  REQUIRE(machines.advance(1s, timeouts) == 0);
+  REQUIRE(machines.is_in<Idle>(1));
+  REQUIRE(machines.armed() == 0);
+  REQUIRE(machines.now() == 1100);
+}
+
+TEST_CASE("Timeouts beyond the span of the wheel") {
+  machines_t machines(2);
+  REQUIRE(machines.event<Sleep>(0));
+  REQUIRE(machines.advance(5h, 0) == 0);
+  REQUIRE(machines.event<Sleep>(1));
+  REQUIRE(machines.advance(4h, 0) == 0);
+  REQUIRE(machines.is_in<Sleeping>(0));
+
+  REQUIRE(machines.advance(59min + 59s + 999ms) == 0);
+  REQUIRE(machines.advance(1ms) == 1);
+  REQUIRE(machines.is_in<Idle>(0));
+  REQUIRE(machines.is_in<Sleeping>(1));
+  REQUIRE(machines.advance(5h) == 1);
+  REQUIRE(machines.is_in<Idle>(1));
+}
+
+TEST_CASE("Timing wheel matches a naive timer list") {
+  constexpr std::size_t count = 500;
+  machines_t machines(count);
+  std::vector<std::uint64_t> deadline(count, 0);
+  std::mt19937 random(7);
+  std::uint64_t now = 0;
+  std::size_t timeouts = 0;
+  std::size_t expected = 0;
+
+  for (int round = 0; round < 2000; ++round) {
+    const std::size_t idx = random() % count;
+    if (machines.is_in<Idle>(idx)) {
+      REQUIRE(machines.event<Connect>(idx));
+      deadline[idx] = now + 100;
+    } else if (random() % 2) {
+      REQUIRE(machines.event<Ping>(idx));
+      deadline[idx] = now + 100;
+    } else {
+      REQUIRE(machines.event<Reply>(idx));
+      deadline[idx] = 0;
+    }
+
+    const std::uint64_t step = random() % (round % 100 == 0 ? 5000 : 20);
+    for (std::size_t m = 0; m < count; ++m)
+      if (deadline[m] && deadline[m] <= now + step) {
+        ++expected;
+        deadline[m] = 0;
+      }
+    machines.advance(std::chrono::milliseconds(step), timeouts);
+    now += step;
+    REQUIRE(timeouts == expected);
+    for (std::size_t m = 0; m < count; ++m)
+      REQUIRE(machines.is_in<Waiting>(m) == (deadline[m] != 0));
+  }
+}
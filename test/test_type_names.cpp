@@ -0,0 +1,50 @@
+#include <catch2/catch_test_macros.hpp>
+#include <pure/fsm.hpp>
+#include <pure/logger.hpp>
+#include <string_view>
+
+struct StateA {};
+
+struct StateB {};
+
+struct Event {};
+
+struct Guard {};
+
+namespace app {
+  template <int N>
+  struct tagged {};
+} // namespace app
+
+using pure::none;
+using pure::tr;
+
+using table = pure::transition_table<tr<StateA, Event, StateB, none, Guard>,
+                                     tr<StateB, Event, StateA, none, none>>;
+
+TEST_CASE("Compile-time type names") {
+  using pure::logger::type_name;
+
+  STATIC_REQUIRE(type_name<StateA>() == "StateA");
+  STATIC_REQUIRE(type_name<pure::none>() == "pure::none");
+  STATIC_REQUIRE(type_name<app::tagged<3>>() == "app::tagged<3>");
+
+  // Names are null-terminated, so they may be passed to C interfaces
+  REQUIRE(type_name<Event>().data()[type_name<Event>().size()] == '\0');
+}
+
+TEST_CASE("Type identifiers of a table") {
+  using ids = pure::logger::type_ids<table>;
+
+  STATIC_REQUIRE(ids::size == 5);
+  STATIC_REQUIRE(ids::state_id<StateA> == 0);
+  STATIC_REQUIRE(ids::state_id<StateB> == 1);
+  STATIC_REQUIRE(ids::event_id<Event> == 2);
+  STATIC_REQUIRE(ids::guard_id<Guard> == 3);
+  STATIC_REQUIRE(ids::guard_id<none> == 4);
+
+  STATIC_REQUIRE(ids::name(ids::state_id<StateB>) == "StateB");
+  STATIC_REQUIRE(ids::name(ids::event_id<Event>) == "Event");
+  STATIC_REQUIRE(ids::name(ids::guard_id<none>) == "pure::none");
+  STATIC_REQUIRE(ids::name(ids::size).empty());
+}